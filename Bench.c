@@ -0,0 +1,154 @@
+/** \file
+ *
+ *  Latency benchmark, built in with LATENCY_BENCH (make bench). Instead of playing, the
+ *  firmware presses BENCH_BUTTON at a steady rate with every echo count in turn, and
+ *  measures, in USB frames, how long each press takes to go out and to come back in the
+ *  console's OUT report, which mirrors the controller's state.
+ */
+
+#include <LUFA/Drivers/USB/USB.h>
+#include <string.h>
+#include <util/atomic.h>
+
+#include "Bench.h"
+#include "Host.h"
+#include "Timing.h"
+
+#ifdef LATENCY_BENCH
+
+Bench_t Bench;
+
+// Where the pattern is: the row and press being sent, and whether the press, its release or the gap after is next.
+static uint8_t    Row;
+static uint8_t    Step;
+static Clock_ms_t StepStarted;
+// Frame the current press was queued in, and which of its round trips we still wait for.
+static uint16_t   QueuedFrame;
+static bool       AwaitWire;
+static bool       AwaitMirror;
+
+enum {
+	STEP_SETTLE,
+	STEP_PRESS,
+	STEP_RELEASE,
+	STEP_GAP,
+};
+
+// Frames since the current press was queued, clamped to what a table entry holds.
+static uint8_t Bench_Frames(void)
+{
+	uint16_t Frames = (USB_Device_GetFrameNumber() - QueuedFrame) & 0x7FF;
+
+	return (Frames > UINT8_MAX) ? UINT8_MAX : Frames;
+}
+
+void Bench_Start(const Clock_ms_t Now)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		memset(&Bench, 0, sizeof(Bench));
+		Bench.Version   = BENCH_VERSION;
+		Bench.PollingMS = POLLING_MS;
+		for (uint8_t Index = 0; Index < BENCH_ROWS; Index++)
+			Bench.Rows[Index].Echoes = Index;
+
+		AwaitWire   = false;
+		AwaitMirror = false;
+	}
+
+	Row         = 0;
+	Step        = STEP_SETTLE;
+	StepStarted = Now;
+}
+
+bool Bench_NextReport(USB_JoystickReport_Input_t* const ReportData, const Clock_ms_t Now)
+{
+	BenchRow_t* Current = &Bench.Rows[Row];
+
+	switch (Step)
+	{
+		case STEP_SETTLE:
+			if ((Clock_ms_t)(Now - StepStarted) < BENCH_SETTLE_MS)
+				return true;
+			break;
+
+		case STEP_GAP:
+			if ((Clock_ms_t)(Now - StepStarted) < BENCH_GAP_MS)
+				return true;
+
+			// A press whose round trip hasn't come back by now doesn't count as registered.
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				AwaitWire   = false;
+				AwaitMirror = false;
+			}
+
+			if (Current->Presses == BENCH_PRESSES && ++Row == BENCH_ROWS)
+			{
+#ifdef HOST_TIMING
+				Bench.INInterval = HostTiming.INInterval;
+#endif
+				Bench.Done = true;
+				return false;
+			}
+			Current = &Bench.Rows[Row];
+			break;
+
+		case STEP_PRESS:
+			// The press is followed by its release straight away, each sent 1 + Echoes times.
+			Step = STEP_RELEASE;
+			return true;
+
+		case STEP_RELEASE:
+			Step = STEP_GAP;
+			return true;
+	}
+
+	// Time for the next press.
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		QueuedFrame = USB_Device_GetFrameNumber();
+		AwaitWire   = true;
+		AwaitMirror = true;
+		Current->Presses++;
+	}
+
+	ReportData->Button |= BENCH_BUTTON;
+	Step        = STEP_PRESS;
+	StepStarted = Now;
+	return true;
+}
+
+uint8_t Bench_Echoes(void)
+{
+	return Bench.Rows[Row < BENCH_ROWS ? Row : BENCH_ROWS - 1].Echoes;
+}
+
+void Bench_RecordIN(const USB_JoystickReport_Input_t* const ReportData)
+{
+	if (!AwaitWire || !(ReportData->Button & BENCH_BUTTON))
+		return;
+
+	uint8_t Frames = Bench_Frames();
+
+	Bench.Rows[Row].WireTotal += Frames;
+	if (Frames > Bench.Rows[Row].WireMax)
+		Bench.Rows[Row].WireMax = Frames;
+	AwaitWire = false;
+}
+
+void Bench_RecordOUT(const USB_JoystickReport_Output_t* const ReportData)
+{
+	if (!AwaitMirror || AwaitWire || !(ReportData->Button & BENCH_BUTTON))
+		return;
+
+	uint8_t Frames = Bench_Frames();
+
+	Bench.Rows[Row].Registered++;
+	Bench.Rows[Row].MirrorTotal += Frames;
+	if (Frames > Bench.Rows[Row].MirrorMax)
+		Bench.Rows[Row].MirrorMax = Frames;
+	AwaitMirror = false;
+}
+
+#endif
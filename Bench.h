@@ -0,0 +1,67 @@
+/** \file
+ *
+ *  Header file for Bench.c.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+/* Includes: */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Report.h"
+#include "Clock.h"
+
+// Macros
+// Layout version of Bench_t, bumped whenever a field is added or moved.
+#define BENCH_VERSION 1
+
+// Each row of the table presses BENCH_BUTTON BENCH_PRESSES times, sending every report 1 + its echo count times.
+// The rows go through echo counts 0 to BENCH_ROWS - 1.
+#define BENCH_ROWS    4
+#define BENCH_PRESSES 20
+#define BENCH_BUTTON  SWITCH_A
+// Time from one press to the next, so the console's mirror of a press has come back before the next one (in ms).
+#define BENCH_GAP_MS  250
+// Time to wait after the controller sync before the first press (in ms).
+#define BENCH_SETTLE_MS 2000
+
+// Type Defines
+// Results for one echo count. Latencies are in USB frames (1 ms each), summed over the presses for the average.
+typedef struct {
+	uint8_t  Echoes;      // Times each report was repeated after the first
+	uint8_t  Presses;     // Presses sent
+	uint8_t  Registered;  // Presses the console mirrored back in an OUT report before the next one
+	uint8_t  WireMax;     // Longest time from queuing a press to it going out
+	uint8_t  MirrorMax;   // Longest time from queuing a press to the console mirroring it back
+	uint8_t  Reserved;    // 0, keeps the fields below aligned so hosts see the same layout
+	uint16_t WireTotal;
+	uint16_t MirrorTotal; // Only of the presses that were registered
+} BenchRow_t;
+
+// Latency table, read out by a PC with the VENDOR_REQ_GetBench control request.
+// The layout is little endian and packed as declared, see Tools/splatctl.py.
+typedef struct {
+	uint8_t    Version;    // BENCH_VERSION
+	uint8_t    PollingMS;  // POLLING_MS this build asked the host for
+	uint8_t    INInterval; // Time between the host's IN polls as measured, in ms (0 in builds that don't time the host)
+	uint8_t    Done;       // Set once every row has been run
+	BenchRow_t Rows[BENCH_ROWS];
+} Bench_t;
+
+// Variables
+extern Bench_t Bench;
+
+// Function Prototypes
+// Start the benchmark over, with an empty table.
+void Bench_Start(const Clock_ms_t Now);
+// Build the next report of the input pattern. Returns false once every row has been run.
+bool Bench_NextReport(USB_JoystickReport_Input_t* const ReportData, const Clock_ms_t Now);
+// Number of echoes for the reports built so far.
+uint8_t Bench_Echoes(void);
+// Note a report as it goes out to the host, and an OUT report from it.
+void Bench_RecordIN(const USB_JoystickReport_Input_t* const ReportData);
+void Bench_RecordOUT(const USB_JoystickReport_Output_t* const ReportData);
+
+#endif
@@ -0,0 +1,105 @@
+/** \file
+ *
+ *  Millisecond clock used to schedule macro steps in real time, independently of
+ *  how often the host polls us or how many times each report is echoed.
+ *
+ *  Built with FRAME_CLOCK, the clock follows the host's 1 ms USB frames instead of our own
+ *  crystal, so a step of so many milliseconds always spans the same number of polls.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "Clock.h"
+
+static volatile Clock_ms_t Clock_Ticks = 0;
+static volatile uint32_t   Clock_WholeSeconds = 0;
+static uint16_t            Clock_SubSecond = 0;
+
+// Configures Timer1 to fire a compare match interrupt once every millisecond.
+void Clock_Init(void)
+{
+	// CTC mode, clocked at F_CPU/8, so each millisecond is CLOCK_COUNTS_PER_MS timer counts.
+	TCCR1A = 0;
+	TCCR1B = (1 << WGM12) | (1 << CS11);
+	OCR1A  = CLOCK_COUNTS_PER_MS - 1;
+	TIMSK1 = (1 << OCIE1A);
+}
+
+static inline void Clock_Tick(void)
+{
+	Clock_Ticks++;
+
+	if (++Clock_SubSecond == 1000)
+	{
+		Clock_SubSecond = 0;
+		Clock_WholeSeconds++;
+	}
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+	Clock_Tick();
+#ifdef FRAME_CLOCK
+	// No frame came in time, so we keep counting on our own until they come back.
+	OCR1A = CLOCK_COUNTS_PER_MS - 1;
+#endif
+}
+
+#ifdef FRAME_CLOCK
+// Called from the USB interrupt at every start of frame. The timer starts over with the frame, with
+// enough slack that the host's clock running a little slower than ours never counts a frame twice.
+void Clock_Frame(void)
+{
+	TCNT1  = 0;
+	OCR1A  = CLOCK_COUNTS_PER_MS + CLOCK_FRAME_SLACK - 1;
+	TIFR1  = (1 << OCF1A);
+	Clock_Tick();
+}
+#endif
+
+// Returns the current millisecond count. The counter is wider than a byte, so we read it atomically.
+Clock_ms_t Clock_Millis(void)
+{
+	Clock_ms_t Now;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Now = Clock_Ticks;
+	}
+
+	return Now;
+}
+
+// Returns the number of whole seconds since Clock_Init(). This doesn't wrap for over a century.
+uint32_t Clock_Seconds(void)
+{
+	uint32_t Seconds;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Seconds = Clock_WholeSeconds;
+	}
+
+	return Seconds;
+}
+
+// Returns the millisecond count scaled to timer counts, plus how far into the current millisecond we are.
+uint16_t Clock_Counts(void)
+{
+	Clock_ms_t Ticks;
+	uint16_t   Counts;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Ticks  = Clock_Ticks;
+		Counts = TCNT1;
+
+		// The timer may have wrapped since interrupts were blocked, before the tick could be counted.
+		if ((TIFR1 & (1 << OCF1A)) && Counts < CLOCK_COUNTS_PER_MS / 2)
+			Ticks++;
+	}
+
+	return (uint16_t)(Ticks * CLOCK_COUNTS_PER_MS) + Counts;
+}
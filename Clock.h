@@ -0,0 +1,42 @@
+/** \file
+ *
+ *  Header file for Clock.c.
+ */
+
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+/* Includes: */
+#include <stdint.h>
+
+// Macros
+// Timer1 runs at F_CPU / CLOCK_PRESCALER, and wraps once every millisecond.
+#define CLOCK_PRESCALER     8
+#define CLOCK_COUNTS_PER_MS (F_CPU / CLOCK_PRESCALER / 1000)
+#ifdef FRAME_CLOCK
+// With FRAME_CLOCK, every USB start of frame counts a millisecond and restarts Timer1, which only counts
+// one itself once a frame is this many timer counts late, e.g. while the bus is suspended.
+#define CLOCK_FRAME_SLACK   (CLOCK_COUNTS_PER_MS / 8)
+#endif
+
+// Type Defines
+// Milliseconds elapsed since Clock_Init(). This wraps roughly every 65 seconds,
+// so only ever compare two readings by subtracting them.
+typedef uint16_t Clock_ms_t;
+
+// Function Prototypes
+// Start the free-running millisecond clock.
+void Clock_Init(void);
+#ifdef FRAME_CLOCK
+// Count the millisecond of a USB frame that has just started. Call this from the start of frame event.
+void Clock_Frame(void);
+#endif
+// Read the current millisecond count.
+Clock_ms_t Clock_Millis(void);
+// Read the uptime in seconds.
+uint32_t Clock_Seconds(void);
+// Read a free-running count of CLOCK_PRESCALER CPU cycles each, for timing short stretches of code.
+// This wraps roughly every 32 ms, so only ever compare two readings by subtracting them.
+uint16_t Clock_Counts(void);
+
+#endif
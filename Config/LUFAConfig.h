@@ -15,26 +15,38 @@
 		// #define NO_CLASS_DRIVER_AUTOFLUSH
 
 		// General USB Driver Related Tokens
-		// #define ORDERED_EP_CONFIG
+		#if defined(LEAN_BUILD)
+		// The endpoints are configured in ascending order (see EVENT_USB_Device_ConfigurationChanged()).
+		#define ORDERED_EP_CONFIG
+		#endif
 		#define USE_STATIC_OPTIONS               (USB_DEVICE_OPT_FULLSPEED | USB_OPT_REG_ENABLED | USB_OPT_AUTO_PLL)
 		#define USB_DEVICE_ONLY
 		// #define USB_HOST_ONLY
 		// #define USB_STREAM_TIMEOUT_MS            {Insert Value Here}
 		// #define NO_LIMITED_CONTROLLER_CONNECT
-		// #define NO_SOF_EVENTS
+		#if !defined(INTERRUPT_DRIVEN) && !defined(FRAME_CLOCK)
+		// Only the interrupt driven and frame clock builds handle the start of frame event.
+		#define NO_SOF_EVENTS
+		#endif
 
 		// USB Device Mode Driver Related Tokens
 		// #define USE_RAM_DESCRIPTORS
 		#define USE_FLASH_DESCRIPTORS
 		// #define USE_EEPROM_DESCRIPTORS
-		// #define NO_INTERNAL_SERIAL
+		// The device descriptor has no serial number.
+		#define NO_INTERNAL_SERIAL
 		#define FIXED_CONTROL_ENDPOINT_SIZE      64
-		// #define DEVICE_STATE_AS_GPIOR            {Insert Value Here}
+		#if defined(LEAN_BUILD)
+		#define DEVICE_STATE_AS_GPIOR            0
+		#endif
 		#define FIXED_NUM_CONFIGURATIONS         1
 		// #define CONTROL_ONLY_DEVICE
-		// #define INTERRUPT_CONTROL_ENDPOINT
-		// #define NO_DEVICE_REMOTE_WAKEUP
-		// #define NO_DEVICE_SELF_POWER
+		#if defined(INTERRUPT_DRIVEN)
+		#define INTERRUPT_CONTROL_ENDPOINT
+		#endif
+		// The configuration is bus powered and doesn't offer remote wakeup.
+		#define NO_DEVICE_REMOTE_WAKEUP
+		#define NO_DEVICE_SELF_POWER
 
 		// USB Host Mode Driver Related Tokens
 		// #define HOST_STATE_AS_GPIOR              {Insert Value Here}
@@ -0,0 +1,43 @@
+// Timing profile configuration. The endpoint polling interval, the number of times each report is
+// echoed and the macro tick size all depend on each other, so they are picked together here.
+#ifndef _TIMING_H_
+#define _TIMING_H_
+	// Available profiles. Select one with -DTIMING_PROFILE=... (see the with-*-timing makefile targets).
+	#define TIMING_PROFILE_CONSERVATIVE 0
+	#define TIMING_PROFILE_DEFAULT      1
+	#define TIMING_PROFILE_FAST         2
+
+	#ifndef TIMING_PROFILE
+		#define TIMING_PROFILE TIMING_PROFILE_DEFAULT
+	#endif
+
+	#if (TIMING_PROFILE == TIMING_PROFILE_CONSERVATIVE)
+		// Every report stays on the wire for 32 ms.
+		#define POLLING_MS    8
+		#define ECHOES        3
+		#define MACRO_TICK_MS 8
+	#elif (TIMING_PROFILE == TIMING_PROFILE_DEFAULT)
+		// Every report stays on the wire for 24 ms. This is what the firmware has always used.
+		#define POLLING_MS    8
+		#define ECHOES        2
+		#define MACRO_TICK_MS 8
+	#elif (TIMING_PROFILE == TIMING_PROFILE_FAST)
+		// Ask to be polled every frame and never echo. Macro holds still set how long an input is down.
+		#define POLLING_MS    1
+		#define ECHOES        0
+		#define MACRO_TICK_MS 4
+	#else
+		#error Unknown TIMING_PROFILE.
+	#endif
+
+	// Smallest MACRO_TICK_MS of any profile above. Tools/macroc sizes the steps it compiles for this, so
+	// Macros.c builds with every profile.
+	#define MACRO_TICK_MS_MIN 4
+
+	// Shortest time a report can be seen by the host, in ms.
+	#define REPORT_WINDOW_MS (POLLING_MS * (1 + ECHOES))
+
+	// Shortest release between two presses of the same input for the game to register both, in ms.
+	// The host has to see at least one report with the input let go, so this is one report window.
+	#define RELEASE_GAP_MS   REPORT_WINDOW_MS
+#endif
@@ -0,0 +1,21 @@
+/** \file
+ *
+ *  Throughput counters, so a PC can log matches per hour per rig and spot units
+ *  that have stopped making progress.
+ */
+
+#include "Counters.h"
+
+Counters_t Counters = {
+	.Version = COUNTERS_VERSION,
+};
+
+void Counters_Count(const uint8_t Id)
+{
+	switch (Id)
+	{
+		case COUNTER_TURNS:
+			Counters.Turns++;
+			break;
+	}
+}
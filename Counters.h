@@ -0,0 +1,44 @@
+/** \file
+ *
+ *  Header file for Counters.c.
+ */
+
+#ifndef _COUNTERS_H_
+#define _COUNTERS_H_
+
+/* Includes: */
+#include <stdint.h>
+
+// Macros
+// Layout version of Counters_t, bumped whenever a field is added or moved.
+#define COUNTERS_VERSION 3
+
+// Type Defines
+// Throughput counters, read out by a PC with the VENDOR_REQ_GetCounters control request.
+// The layout is little endian and packed as declared, see Tools/splatctl.py.
+typedef struct {
+	uint8_t  Version; // COUNTERS_VERSION
+	uint8_t  State;   // Current State_t of the report state machine
+	uint16_t Syncs;   // Times the host has (re)configured us
+	uint32_t Uptime;  // Seconds since power up
+	uint32_t Reports; // IN reports sent to the host
+	uint32_t Cycles;  // Matches played through every phase
+	uint32_t Turns;   // Turns passed, counted by COUNT(COUNTER_TURNS) in the macro
+	uint16_t Recoveries; // Runs of the recover[] macro
+	uint8_t  ResetCause; // MCUSR at power up, WDRF is set if the watchdog had to reset us
+	uint8_t  Rival;      // Rival being played by place in the rotation, 0 without RIVAL_ROTATION
+} Counters_t;
+
+// Counters a macro can bump with COUNT().
+typedef enum {
+	COUNTER_TURNS,
+} CounterIds_t;
+
+// Variables
+extern Counters_t Counters;
+
+// Function Prototypes
+// Bump one of the macro counters.
+void Counters_Count(const uint8_t Id);
+
+#endif
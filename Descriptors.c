@@ -79,6 +79,57 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor = {
 	.NumberOfConfigurations = FIXED_NUM_CONFIGURATIONS
 };
 
+// Interface and endpoint descriptors of one pad. Every pad is the same controller, on its own interface and endpoints.
+#define PAD_DESCRIPTORS(Pad) \
+	{ \
+		.HID_Interface = \
+			{ \
+				.Header                 = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface}, \
+ \
+				.InterfaceNumber        = INTERFACE_ID_Joystick + (Pad), \
+				.AlternateSetting       = 0x00, \
+ \
+				.TotalEndpoints         = 2, \
+ \
+				.Class                  = HID_CSCP_HIDClass, \
+				.SubClass               = HID_CSCP_NonBootSubclass, \
+				.Protocol               = HID_CSCP_NonBootProtocol, \
+ \
+				.InterfaceStrIndex      = NO_DESCRIPTOR \
+			}, \
+ \
+		.HID_JoystickHID = \
+			{ \
+				.Header                 = {.Size = sizeof(USB_HID_Descriptor_HID_t), .Type = HID_DTYPE_HID}, \
+ \
+				.HIDSpec                = VERSION_BCD(1,1,1), \
+				.CountryCode            = 0x00, \
+				.TotalReportDescriptors = 1, \
+				.HIDReportType          = HID_DTYPE_Report, \
+				.HIDReportLength        = sizeof(JoystickReport) \
+			}, \
+ \
+		.HID_ReportINEndpoint = \
+			{ \
+				.Header                 = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint}, \
+ \
+				.EndpointAddress        = PAD_IN_EPADDR(Pad), \
+				.Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA), \
+				.EndpointSize           = JOYSTICK_EPSIZE, \
+				.PollingIntervalMS      = POLLING_MS \
+			}, \
+ \
+		.HID_ReportOUTEndpoint = \
+			{ \
+				.Header                 = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint}, \
+ \
+				.EndpointAddress        = PAD_OUT_EPADDR(Pad), \
+				.Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA), \
+				.EndpointSize           = JOYSTICK_EPSIZE, \
+				.PollingIntervalMS      = POLLING_MS \
+			} \
+	}
+
 // Configuration Descriptor Structure
 const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
 	.Config =
@@ -86,7 +137,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
 			.Header                 = {.Size = sizeof(USB_Descriptor_Configuration_Header_t), .Type = DTYPE_Configuration},
 
 			.TotalConfigurationSize = sizeof(USB_Descriptor_Configuration_t),
-			.TotalInterfaces        = 1,
+			.TotalInterfaces        = PADS,
 
 			.ConfigurationNumber    = 1,
 			.ConfigurationStrIndex  = NO_DESCRIPTOR,
@@ -96,51 +147,15 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
 			.MaxPowerConsumption    = USB_CONFIG_POWER_MA(500)
 		},
 
-	.HID_Interface =
-		{
-			.Header                 = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
-
-			.InterfaceNumber        = INTERFACE_ID_Joystick,
-			.AlternateSetting       = 0x00,
-
-			.TotalEndpoints         = 2,
-
-			.Class                  = HID_CSCP_HIDClass,
-			.SubClass               = HID_CSCP_NonBootSubclass,
-			.Protocol               = HID_CSCP_NonBootProtocol,
-
-			.InterfaceStrIndex      = NO_DESCRIPTOR
-		},
-
-	.HID_JoystickHID =
+	.Pads =
 		{
-			.Header                 = {.Size = sizeof(USB_HID_Descriptor_HID_t), .Type = HID_DTYPE_HID},
-
-			.HIDSpec                = VERSION_BCD(1,1,1),
-			.CountryCode            = 0x00,
-			.TotalReportDescriptors = 1,
-			.HIDReportType          = HID_DTYPE_Report,
-			.HIDReportLength        = sizeof(JoystickReport)
-		},
-
-	.HID_ReportINEndpoint =
-		{
-			.Header                 = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
-
-			.EndpointAddress        = JOYSTICK_IN_EPADDR,
-			.Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
-			.EndpointSize           = JOYSTICK_EPSIZE,
-			.PollingIntervalMS      = POLLING_MS
-		},
-
-	.HID_ReportOUTEndpoint =
-		{
-			.Header                 = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
-
-			.EndpointAddress        = JOYSTICK_OUT_EPADDR,
-			.Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
-			.EndpointSize           = JOYSTICK_EPSIZE,
-			.PollingIntervalMS      = POLLING_MS
+			PAD_DESCRIPTORS(0),
+#if PADS > 1
+			PAD_DESCRIPTORS(1),
+#endif
+#if PADS > 2
+			PAD_DESCRIPTORS(2),
+#endif
 		}
 };
 
@@ -192,7 +207,8 @@ uint16_t CALLBACK_USB_GetDescriptor(
 
 			break;
 		case DTYPE_HID:
-			Address = &ConfigurationDescriptor.HID_JoystickHID;
+			// This is asked of an interface, so wIndex says which pad's it is.
+			Address = &ConfigurationDescriptor.Pads[(wIndex < PADS) ? wIndex : 0].HID_JoystickHID;
 			Size    = sizeof(USB_HID_Descriptor_HID_t);
 			break;
 		case DTYPE_Report:
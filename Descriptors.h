@@ -6,23 +6,45 @@
 
 #include <avr/pgmspace.h>
 
+#include "Timing.h"
+
+// Macros
+// Number of pads the device offers the host, each its own HID interface with its own pair of endpoints.
+// Every pad beyond the first plays its own session (see Joystick.c), where the console lets a second
+// controller play. Set with make PADS=2.
+#ifndef PADS
+	#define PADS 1
+#endif
+#if PADS < 1 || PADS > 3
+	#error PADS has to be 1 to 3: each pad takes two of the six endpoints next to the control endpoint.
+#endif
+#if PADS > 1 && (defined(__AVR_ATmega8U2__) || defined(__AVR_ATmega16U2__) || defined(__AVR_ATmega32U2__))
+	#error The U2 parts only have the endpoint memory for one pad, build PADS > 1 for the atmega32u4 or at90usb1286.
+#endif
+
 // Type Defines
-// Device Configuration Descriptor Structure
+// Interface and endpoints of one pad
 typedef struct
 {
-	USB_Descriptor_Configuration_Header_t Config;
-
-	// Joystick HID Interface
 	USB_Descriptor_Interface_t            HID_Interface;
 	USB_HID_Descriptor_HID_t              HID_JoystickHID;
 	USB_Descriptor_Endpoint_t             HID_ReportOUTEndpoint;
 	USB_Descriptor_Endpoint_t             HID_ReportINEndpoint;
+} USB_Descriptor_Pad_t;
+
+// Device Configuration Descriptor Structure
+typedef struct
+{
+	USB_Descriptor_Configuration_Header_t Config;
+
+	// Joystick HID Interfaces
+	USB_Descriptor_Pad_t                  Pads[PADS];
 } USB_Descriptor_Configuration_t;
 
 // Device Interface Descriptor IDs
 enum InterfaceDescriptors_t
 {
-	INTERFACE_ID_Joystick = 0, /**< Joystick interface descriptor ID */
+	INTERFACE_ID_Joystick = 0, /**< Joystick interface descriptor ID of the first pad, the others follow */
 };
 
 // Device String Descriptor IDs
@@ -33,10 +55,24 @@ enum StringDescriptors_t
 	STRING_ID_Product      = 2, // Product string ID
 };
 
+// Vendor specific control requests, sent by the tools in Tools/ from a PC. The Switch never sends these.
+enum VendorRequests_t
+{
+	VENDOR_REQ_GetCounters   = 1, // Device to host: the Counters_t block
+	VENDOR_REQ_ResetCounters = 2, // Host to device, no data: zero the throughput counters, and clear the probes and the trace of builds that have them
+	VENDOR_REQ_WriteProfile  = 3, // Host to device: up to PROFILE_CHUNK_SIZE bytes of the EEPROM profile, at offset wValue
+	VENDOR_REQ_LoadProfile   = 4, // Device to host: check the EEPROM profile and use it from the next program, returns a ProfileStatus_t byte
+	VENDOR_REQ_GetProbes     = 5, // Device to host: the Probes_t block, only answered by profiling builds
+	VENDOR_REQ_GetBench      = 6, // Device to host: the Bench_t latency table, only answered by benchmark builds
+	VENDOR_REQ_GetTrace      = 7, // Device to host: the Trace_t event ring, only answered by trace builds
+};
+
 // Macros
-// Endpoint Addresses
-#define JOYSTICK_IN_EPADDR  (ENDPOINT_DIR_IN  | 1)
-#define JOYSTICK_OUT_EPADDR (ENDPOINT_DIR_OUT | 2)
+// Endpoint Addresses of each pad, the first pad's are 1 and 2
+#define PAD_IN_EPADDR(Pad)  (ENDPOINT_DIR_IN  | (1 + 2 * (Pad)))
+#define PAD_OUT_EPADDR(Pad) (ENDPOINT_DIR_OUT | (2 + 2 * (Pad)))
+#define JOYSTICK_IN_EPADDR  PAD_IN_EPADDR(0)
+#define JOYSTICK_OUT_EPADDR PAD_OUT_EPADDR(0)
 // HID Endpoint Size
 // The Switch -needs- this to be 64.
 // The Wii U is flexible, allowing us to use the default of 8 (which did not match the original Hori descriptors).
@@ -45,8 +81,8 @@ enum StringDescriptors_t
 #define DTYPE_HID                 0x21
 // Descriptor Header Type - HID Class HID Report Descriptor
 #define DTYPE_Report              0x22
-// Joystick endpoint polling interval (in ms). It looks like any value set here renders in a timing multiple of 8 ms.
-#define POLLING_MS 8
+// The joystick endpoint polling interval (POLLING_MS) comes from the timing profile in Config/Timing.h.
+// The Switch has been seen polling in multiples of 8 ms whatever we ask for; build with PROFILE_CHECK to see what it does with yours.
 
 // Function Prototypes
 uint16_t CALLBACK_USB_GetDescriptor(
@@ -0,0 +1,64 @@
+/** \file
+ *
+ *  Timing of the host's IN polls and OUT reports, so macros can pace themselves
+ *  on what the console is actually doing instead of sleeping for a fixed time.
+ */
+
+#include "Host.h"
+
+HostTiming_t HostTiming;
+
+// Returns true when the two intervals are within HOST_POLL_TOLERANCE_MS of each other.
+static bool Host_SameCadence(const uint8_t A, const uint8_t B)
+{
+	return (A > B ? A - B : B - A) <= HOST_POLL_TOLERANCE_MS;
+}
+
+void Host_RecordIN(const Clock_ms_t Now)
+{
+	Clock_ms_t Interval = Now - HostTiming.LastIN;
+	if (Interval > UINT8_MAX)
+		Interval = UINT8_MAX;
+
+	if (Host_SameCadence(Interval, HostTiming.INInterval))
+	{
+		if (HostTiming.SteadyPolls < UINT8_MAX)
+			HostTiming.SteadyPolls++;
+	}
+	else
+	{
+		HostTiming.SteadyPolls = 0;
+	}
+
+	HostTiming.INInterval = Interval;
+	HostTiming.LastIN     = Now;
+}
+
+void Host_RecordOUT(const Clock_ms_t Now)
+{
+	HostTiming.LastOUT = Now;
+	HostTiming.OUTCount++;
+}
+
+uint8_t Host_Snapshot(const HostWait_t Wait)
+{
+	return (Wait == HOST_WAIT_OUT) ? HostTiming.OUTCount : HostTiming.INInterval;
+}
+
+bool Host_WaitDone(const HostWait_t Wait, const uint8_t Snapshot, const Clock_ms_t Now)
+{
+	// If the host has gone quiet for longer than its usual interval, its cadence has changed too.
+	bool Polling = (Clock_ms_t)(Now - HostTiming.LastIN) <= HostTiming.INInterval + HOST_POLL_TOLERANCE_MS;
+
+	switch (Wait)
+	{
+		case HOST_WAIT_SETTLE:
+			return Polling && (HostTiming.SteadyPolls >= HOST_STEADY_POLLS);
+		case HOST_WAIT_CHANGE:
+			return !Polling || !Host_SameCadence(HostTiming.INInterval, Snapshot);
+		case HOST_WAIT_OUT:
+			return HostTiming.OUTCount != Snapshot;
+	}
+
+	return false;
+}
@@ -0,0 +1,55 @@
+/** \file
+ *
+ *  Header file for Host.c.
+ */
+
+#ifndef _HOST_H_
+#define _HOST_H_
+
+/* Includes: */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Clock.h"
+
+// Macros
+// The fast controller sync, host paced macro waits and the timing profile check all rely on the host's poll timing.
+#if !defined(FIXED_SYNC) || defined(HOST_PACING) || defined(PROFILE_CHECK)
+	#define HOST_TIMING
+#endif
+
+// Two consecutive IN polls this close together (in ms) count as the same cadence.
+#define HOST_POLL_TOLERANCE_MS 1
+// How many polls in a row at the same cadence mean the host has settled.
+#define HOST_STEADY_POLLS      8
+
+// Type Defines
+// What we have observed of the host's traffic so far.
+typedef struct {
+	Clock_ms_t LastIN;      // When the host last took an IN report
+	Clock_ms_t LastOUT;     // When the host last sent us an OUT report
+	uint8_t    INInterval;  // Time between the last two IN polls, in ms
+	uint8_t    SteadyPolls; // How many polls in a row matched the previous interval
+	uint8_t    OUTCount;    // Number of OUT reports received, wrapping
+} HostTiming_t;
+
+// Host events a macro can wait for.
+typedef enum {
+	HOST_WAIT_SETTLE, // The host polls at a steady cadence
+	HOST_WAIT_CHANGE, // The host's poll cadence differs from when we started waiting
+	HOST_WAIT_OUT,    // The host sends an OUT report
+} HostWait_t;
+
+// Variables
+extern HostTiming_t HostTiming;
+
+// Function Prototypes
+// Timestamp an IN poll or an OUT report from the host.
+void Host_RecordIN(const Clock_ms_t Now);
+void Host_RecordOUT(const Clock_ms_t Now);
+// Capture what a wait compares against when it starts.
+uint8_t Host_Snapshot(const HostWait_t Wait);
+// Returns true once the awaited host event has happened.
+bool Host_WaitDone(const HostWait_t Wait, const uint8_t Snapshot, const Clock_ms_t Now);
+
+#endif
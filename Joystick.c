@@ -27,33 +27,431 @@ these buttons for our use.
 #include "Joystick.h"
 
 typedef enum {
-	UP,
-	DOWN,
-	LEFT,
-	RIGHT,
-	A,
-	B,
-	NOTHING
-} Buttons_t;
+	SYNC_CONTROLLER,
+	BREATHE,
+	PROCESS,
+	RECOVER,
+	DONE,
+	BENCH,
+	STREAM
+} State_t;
 
-typedef struct {
-	Buttons_t button;
-	uint16_t duration;
-} command;
-
-static const command step[] = {
-	{ NOTHING,  1 },
-	{ B,   5 },
-	{ NOTHING,  1 },
-	{ DOWN,   5 }, 
-	{ NOTHING,  1 },
-	{ DOWN,   5 },
-	{ NOTHING,  1 },
-	{ A,   5 },
-	{ NOTHING,  1 },
-	{ A,   5 }
+// Reports built ahead of the host's polls, for each pad.
+ReportQueue_t queues[PADS];
+
+// A report with nothing pressed and every stick centered.
+static const USB_JoystickReport_Input_t PROGMEM neutral_report = {
+	.Button = 0,
+	.HAT    = HAT_CENTER,
+	.LX     = STICK_CENTER,
+	.LY     = STICK_CENTER,
+	.RX     = STICK_CENTER,
+	.RY     = STICK_CENTER,
 };
 
+// Controller sync sequence timing (in ms): L is pressed at 500 and 1000, A at 1500 and 2000.
+#define SYNC_MS       2000
+#define SYNC_PRESS_MS 50
+
+#ifndef FIXED_SYNC
+// Fast sync: as soon as the host polls at a steady cadence we press L, L, A, A this far apart (in ms).
+// If the host has not settled by SYNC_FALLBACK_MS, the fixed sequence above is pressed instead.
+#define SYNC_FAST_GAP_MS  100
+#define SYNC_FAST_PRESSES 4
+#define SYNC_FALLBACK_MS  500
+
+// Values of Engine_t.SyncPress besides the index of the fast sync press in progress.
+#define SYNC_WAITING 0xFE
+#define SYNC_FIXED   0xFF
+#endif
+
+// The recover[] macro (see Macros.c) runs after every RECOVER_CYCLES matches, and at the end of the first
+// match that finishes RECOVER_EVERY_S seconds or more after the last recovery. Either can be set to 0 to turn it off.
+#ifndef RECOVER_CYCLES
+	#define RECOVER_CYCLES 10
+#endif
+#ifndef RECOVER_EVERY_S
+	#define RECOVER_EVERY_S 0
+#endif
+
+// Once STOP_AFTER_MATCHES matches have been played, or enough of them to earn STOP_AT_EXP EXP, we stop
+// pressing anything and idle until unplugged. Both are 0 (never stop) by default.
+#ifndef STOP_AFTER_MATCHES
+	#define STOP_AFTER_MATCHES 0
+#endif
+#ifndef STOP_AT_EXP
+	#define STOP_AT_EXP 0
+#endif
+
+// EXP earned per match. We pass every turn, so every match is lost (see the README).
+#define EXP_PER_MATCH 40
+
+// Matches to stop after, whichever of the two targets comes first.
+#if STOP_AT_EXP > 0 && (STOP_AFTER_MATCHES == 0 || (STOP_AT_EXP + EXP_PER_MATCH - 1) / EXP_PER_MATCH < STOP_AFTER_MATCHES)
+	#define TARGET_MATCHES ((STOP_AT_EXP + EXP_PER_MATCH - 1) / EXP_PER_MATCH)
+#else
+	#define TARGET_MATCHES STOP_AFTER_MATCHES
+#endif
+#if TARGET_MATCHES > 65535
+	#error The match target has to fit in 16 bits, lower STOP_AFTER_MATCHES or STOP_AT_EXP.
+#endif
+
+#if TARGET_MATCHES
+// Matches played towards the target. This lives outside .bss so a watchdog reset doesn't start it over.
+static uint16_t matches_played[PADS] __attribute__((section(".noinit")));
+#endif
+
+// Left in RAM while we run, and still there after a reset that isn't a power up (see SetupHardware()).
+#define SESSION_MARKER 0x5353
+static uint16_t session_marker __attribute__((section(".noinit")));
+
+#ifdef RIVAL_ROTATION
+// Rival each pad plays and how fast each one has been (see Rival.c). This also lives outside .bss, so a watchdog
+// reset doesn't throw away the timings or the place in the rotation.
+static Rival_t rivals[PADS] __attribute__((section(".noinit")));
+#endif
+
+// As a last resort, the watchdog resets us if the host hasn't taken a report for this long while configured.
+#define WATCHDOG_TIMEOUT WDTO_2S
+
+// State of the report state machine of one pad, kept together and sized to the range of each field so
+// it costs as little of the 16u2's RAM as possible. Wider fields come first, so nothing is padded on
+// targets that align them.
+typedef struct {
+	uint32_t   LastRecovery;        // When the last recovery ran, in seconds
+	Clock_ms_t StateStarted;        // When the current state was entered
+	uint8_t    State;               // Current State_t
+	// Phase_t of the match we're playing, and how many turns of it have been passed.
+	// These survive a re-sync, so a match that was interrupted carries on where it was.
+	uint8_t    Phase;
+	uint8_t    TurnCount;
+	uint8_t    CyclesSinceRecovery; // Matches played since the last recovery
+	bool       Lost;                // The watchdog had to reset us, so we recover as soon as the controller is synced again
+#ifdef QUICK_PASS
+	bool       OnPass;              // The last turn passed left the cursor on Pass, and nothing has moved it since
+#endif
+#ifndef FIXED_SYNC
+	uint8_t    SyncPress;           // Fast sync press in progress, or SYNC_WAITING/SYNC_FIXED
+	uint8_t    SyncOuts;            // OUT reports this pad has had since the host configured us, saturating
+#endif
+	Macro_t    Macro;               // Interpreter running the current phase's program (see Macros.c)
+} Engine_t;
+
+// Every pad plays its own session. SYNC_CONTROLLER and PHASE_DECK_SELECT are 0, and the sync is set
+// up when the host configures us, so they start out zeroed.
+static Engine_t engines[PADS];
+
+// Times the host has (re)configured us, counted by the control request handler, and how many of those the
+// main loop has started the pads over for.
+static volatile uint8_t configurations;
+static volatile uint8_t configurations_seen;
+// Set by the control request handler once the EEPROM profile has been rewritten or reloaded, until the main
+// loop has stopped the programs that were running from it.
+static volatile bool    profile_changed;
+
+// Time the report being built is for, read once per report so all of its steps agree on it.
+static Clock_ms_t report_time;
+
+#ifdef FRAME_CLOCK
+// Frame in which the host last took a report from each pad. Reports are built for that frame rather than
+// for whenever the main loop gets round to them, so each step lasts a whole number of polls.
+static volatile Clock_ms_t polled_at[PADS];
+#endif
+
+#ifdef PROFILE_CHECK
+// Shows on the alert pins whether the host really polls us as often as the timing profile asked.
+static void checkTimingProfile(void)
+{
+	bool accepted = (HostTiming.SteadyPolls >= HOST_STEADY_POLLS) && (HostTiming.INInterval <= POLLING_MS + HOST_POLL_TOLERANCE_MS);
+	uint8_t pins = accepted ? 0xFF : (uint8_t)~PORTB;
+
+	PORTB = pins;
+	PORTD = pins;
+}
+#endif
+
+// Returns true while we are inside the SYNC_PRESS_MS window that opens at the given time.
+static bool inSyncWindow(Clock_ms_t elapsed, Clock_ms_t start)
+{
+	return (Clock_ms_t)(elapsed - start) < SYNC_PRESS_MS;
+}
+
+// Presses the fixed sync sequence, timed from when the state was entered. Returns true once it is over.
+static bool fixedSync(USB_JoystickReport_Input_t* const ReportData, const Clock_ms_t elapsed)
+{
+	if (elapsed >= SYNC_MS + SYNC_PRESS_MS)
+		return true;
+
+	if (inSyncWindow(elapsed, 500) || inSyncWindow(elapsed, 1000))
+		ReportData->Button |= SWITCH_L;
+	else if (inSyncWindow(elapsed, 1500) || inSyncWindow(elapsed, 2000))
+		ReportData->Button |= SWITCH_A;
+
+	return false;
+}
+
+// Returns the built-in program for a phase, or for one of the other PROFILE_ slots.
+static const uint8_t* builtInProgram(const uint8_t Slot)
+{
+	switch (Slot)
+	{
+#ifdef QUICK_PASS
+		case PROFILE_PASS_AGAIN:
+			return pass_again;
+#endif
+#ifdef RIVAL_ROTATION
+		case PROFILE_RIVAL_LEAVE:
+			return rival_leave;
+		case PROFILE_RIVAL_UP:
+			return rival_up;
+		case PROFILE_RIVAL_DOWN:
+			return rival_down;
+		case PROFILE_RIVAL_PICK:
+			return rival_pick;
+#endif
+		case PHASE_TURN:
+			return pass_turn;
+		case PHASE_RESULTS:
+			return results;
+		case PHASE_POPUPS:
+			return popups;
+		case PHASE_REMATCH:
+			return rematch;
+		case PROFILE_RECOVER:
+			return recover;
+		default:
+			return deck_select;
+	}
+}
+
+// Returns the program slot that plays the current phase. With QUICK_PASS, a turn that starts with the cursor
+// still on Pass from the one before only needs the confirm presses of pass_again[]. With RIVAL_ROTATION, the
+// rematch phase is played by the programs that go to another rival whenever the rotation picks one.
+static uint8_t phaseSlot(const Engine_t* const Engine)
+{
+#ifdef QUICK_PASS
+	if (Engine->Phase == PHASE_TURN && Engine->OnPass)
+		return PROFILE_PASS_AGAIN;
+#endif
+#ifdef RIVAL_ROTATION
+	if (Engine->Phase == PHASE_REMATCH)
+		return Rival_Slot(&rivals[Engine - engines]);
+#endif
+
+	return Engine->Phase;
+}
+
+// Moves the pad's report state machine on to another State_t.
+static void setState(Engine_t* const Engine, const uint8_t State)
+{
+	TRACE(TRACE_STATE, Engine - engines, State);
+	Engine->State = State;
+}
+
+// Notes where the pad's program was when it had to stop before its end.
+static void traceCut(const Engine_t* const Engine)
+{
+#ifdef EVENT_TRACE
+	Trace_Record(TRACE_CUT, Engine - engines, MIN(Engine->Macro.StepPC, UINT8_MAX));
+#else
+	(void)Engine;
+#endif
+}
+
+// Starts the program for a phase, or PROFILE_RECOVER, taking it from the EEPROM profile when that has one.
+// When chaining, it carries on straight from the program that just ended (see Macro_Chain()).
+static void startProgram(Engine_t* const Engine, const uint8_t Slot, const bool Chain)
+{
+	const uint8_t* Program;
+	MacroSource_t  Source = MACRO_EEPROM;
+
+	if (!Profile_Program(Slot, &Program))
+	{
+		Source  = MACRO_FLASH;
+		Program = builtInProgram(Slot);
+	}
+	TRACE(TRACE_PROGRAM, Engine - engines, Slot | (Engine->TurnCount << 4));
+
+	if (Chain)
+		Macro_Chain(&Engine->Macro, Source, Program);
+	else
+		Macro_Start(&Engine->Macro, Source, Program, report_time);
+}
+
+// Stops the programs running from the EEPROM profile, once it has been rewritten or reloaded. A program
+// running from the profile can't carry on, so the current phase starts over from flash after a breath.
+static void stopProfilePrograms(void)
+{
+	for (uint8_t Pad = 0; Pad < PADS; Pad++)
+	{
+		Engine_t* const Engine = &engines[Pad];
+
+		if (Engine->Macro.Source == MACRO_EEPROM && (Engine->State == PROCESS || Engine->State == RECOVER))
+		{
+			traceCut(Engine);
+			setState(Engine, BREATHE);
+		}
+	}
+}
+
+// Moves on to the phase after the one whose program just ended. Returns true once a whole match has been played.
+static bool nextPhase(Engine_t* const Engine)
+{
+	// The turn phase is played once for every turn of the match.
+	if (Engine->Phase == PHASE_TURN && ++Engine->TurnCount < TURNS)
+	{
+#ifdef QUICK_PASS
+		Engine->OnPass = true;
+#endif
+		return false;
+	}
+#ifdef RIVAL_ROTATION
+	// Going to another rival takes several programs in place of rematch[].
+	if (Engine->Phase == PHASE_REMATCH && !Rival_Stepped(&rivals[Engine - engines]))
+		return false;
+#endif
+
+	Engine->TurnCount = 0;
+#ifdef QUICK_PASS
+	// The next match starts on other screens, so its first turn finds its way to Pass again.
+	Engine->OnPass = false;
+#endif
+	if (++Engine->Phase < PHASE_COUNT)
+	{
+#ifdef RIVAL_ROTATION
+		// The match has earned its EXP once the popups are gone, so that's where it is timed and the next rival picked.
+		if (Engine->Phase == PHASE_REMATCH)
+			Rival_MatchPlayed(&rivals[Engine - engines], Clock_Seconds());
+#endif
+		return false;
+	}
+
+	Engine->Phase = PHASE_DECK_SELECT;
+	return true;
+}
+
+// Starts the recover[] macro in place of the current phase.
+static void startRecovery(Engine_t* const Engine)
+{
+	Engine->CyclesSinceRecovery = 0;
+	Engine->LastRecovery = Clock_Seconds();
+	Engine->Lost = false;
+	Counters.Recoveries++;
+
+	// recover[] ends on the deck select screen, so the next match starts from the top.
+	Engine->Phase = PHASE_DECK_SELECT;
+	Engine->TurnCount = 0;
+#ifdef QUICK_PASS
+	Engine->OnPass = false;
+#endif
+#ifdef RIVAL_ROTATION
+	Rival_Recovered(&rivals[Engine - engines]);
+#endif
+
+	setState(Engine, RECOVER);
+	startProgram(Engine, PROFILE_RECOVER, false);
+}
+
+// Returns true once the match that has just been played reached the pad's target.
+static bool targetReached(Engine_t* const Engine)
+{
+#if TARGET_MATCHES
+	return ++matches_played[Engine - engines] >= TARGET_MATCHES;
+#else
+	(void)Engine;
+	return false;
+#endif
+}
+
+// Returns true once every pad has stopped playing.
+static bool allDone(void)
+{
+	for (uint8_t Pad = 0; Pad < PADS; Pad++)
+	{
+		if (engines[Pad].State != DONE)
+			return false;
+	}
+
+	return true;
+}
+
+// Stops the pad playing for good, since its target has been reached.
+static void finish(Engine_t* const Engine)
+{
+	setState(Engine, DONE);
+
+	// Once no pad plays any more, nothing runs but the USB stack and the alert, so we can switch off what we don't use.
+	if (allDone())
+	{
+		power_adc_disable();
+		power_spi_disable();
+	}
+}
+
+// Returns true if it is time to recover, after a match has just been played.
+static bool recoveryDue(Engine_t* const Engine)
+{
+	if (Engine->CyclesSinceRecovery < UINT8_MAX)
+		Engine->CyclesSinceRecovery++;
+
+#if RECOVER_CYCLES
+	if (Engine->CyclesSinceRecovery >= RECOVER_CYCLES)
+		return true;
+#endif
+#if RECOVER_EVERY_S
+	if (Clock_Seconds() - Engine->LastRecovery >= RECOVER_EVERY_S)
+		return true;
+#endif
+
+	return false;
+}
+
+#ifndef FIXED_SYNC
+// Presses the fast sync sequence once the host has settled, falling back to the fixed one. Returns true once it is over.
+static bool fastSync(Engine_t* const Engine, USB_JoystickReport_Input_t* const ReportData, const Clock_ms_t Now)
+{
+	Clock_ms_t elapsed = Now - Engine->StateStarted;
+
+	if (Engine->SyncPress == SYNC_WAITING)
+	{
+		if (Host_WaitDone(HOST_WAIT_SETTLE, 0, Now))
+		{
+			Engine->SyncPress    = 0;
+			Engine->StateStarted = Now;
+			elapsed       = 0;
+		}
+		else if (elapsed >= SYNC_FALLBACK_MS)
+		{
+			// The host hasn't settled in time. The fixed sequence has not pressed anything yet at this point, so it can take over as is.
+			Engine->SyncPress = SYNC_FIXED;
+		}
+	}
+
+	if (Engine->SyncPress == SYNC_WAITING)
+		return false;
+	if (Engine->SyncPress == SYNC_FIXED)
+		return fixedSync(ReportData, elapsed);
+
+	if (elapsed >= SYNC_FAST_GAP_MS)
+	{
+		Engine->SyncPress++;
+		Engine->StateStarted = Now;
+		elapsed       = 0;
+
+		// The console only sends OUT reports to a pad it has registered, so the second L isn't needed.
+		if (Engine->SyncPress == 1 && Engine->SyncOuts)
+			Engine->SyncPress++;
+	}
+
+	if (Engine->SyncPress >= SYNC_FAST_PRESSES)
+		return true;
+
+	if (inSyncWindow(elapsed, 0))
+		ReportData->Button |= (Engine->SyncPress < 2) ? SWITCH_L : SWITCH_A;
+
+	return false;
+}
+#endif
 
 // Main entry point.
 int main(void)
@@ -63,30 +461,128 @@ int main(void)
 	// We'll then enable global interrupts for our use.
 	GlobalInterruptEnable();
 	// Once that's done, we'll enter an infinite loop.
+#ifdef INTERRUPT_DRIVEN
+	// Control requests and the endpoints are both serviced from interrupts, so all that's
+	// left for us is building reports. In between, we sleep until the next interrupt.
+	set_sleep_mode(SLEEP_MODE_IDLE);
 	for (;;)
 	{
+		FillReportQueue();
+		sleep_mode();
+	}
+#else
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	for (;;)
+	{
+		// We build the upcoming reports ahead of time, so answering an IN poll is just a copy.
+		FillReportQueue();
 		// We need to run our task to process and deliver data for our IN and OUT endpoints.
+		PROBE_BEGIN(PROBE_HID_TASK);
 		HID_Task();
+		PROBE_END(PROBE_HID_TASK);
 		// We also need to run the main USB management task.
+		PROBE_BEGIN(PROBE_USB_TASK);
 		USB_USBTask();
+		PROBE_END(PROBE_USB_TASK);
+
+		// Once we're done there is only the odd poll left to answer, and the millisecond clock wakes us up often enough for that.
+		if (allDone())
+			sleep_mode();
 	}
+#endif
 }
 
 // Configures hardware and peripherals, such as the USB peripherals.
 void SetupHardware(void)
 {
-	// We need to disable watchdog if enabled by bootloader/fuses.
+	// We need to disable watchdog if enabled by bootloader/fuses. We'll remember whether it was the watchdog that reset us first.
+	// Any reset sets a flag in MCUSR, so finding none means a bootloader such as Caterina cleared them, and the marker we
+	// left in RAM is all that tells a reset in the middle of a session from a power up.
+	Counters.ResetCause = MCUSR;
+	const bool Unflagged = !MCUSR && session_marker == SESSION_MARKER;
+	const bool Reset     = (MCUSR & (1 << WDRF)) || Unflagged;
+	session_marker = SESSION_MARKER;
+	for (uint8_t Pad = 0; Pad < PADS; Pad++)
+	{
+		Engine_t* const Engine = &engines[Pad];
+
+		Engine->Lost = Reset;
+#ifdef LATENCY_BENCH
+		// The benchmark runs on a test screen rather than in a match, so there is nothing to find our way back to.
+		Engine->Lost = false;
+#endif
+#if TARGET_MATCHES
+		// The matches played so far only carry over a watchdog reset, anything else starts from scratch.
+		if (!Engine->Lost)
+			matches_played[Pad] = 0;
+#endif
+#ifdef RIVAL_ROTATION
+		// So does the rotation, but the match the reset cut short can't be timed: the uptime starts over.
+		if (!Engine->Lost)
+			Rival_Init(&rivals[Pad]);
+		else
+			Rival_Untimed(&rivals[Pad]);
+#endif
+	}
 	MCUSR &= ~(1 << WDRF);
 	wdt_disable();
 
 	// We need to disable clock division before initializing the USB hardware.
 	clock_prescale_set(clock_div_1);
 
+#ifdef INTERRUPT_DRIVEN
+	// We'll be sleeping between interrupts, so we also switch off the peripherals we don't use.
+	power_adc_disable();
+	power_spi_disable();
+#endif
+
+#if defined(LATENCY_BENCH) && PADS > 1
+	#error The latency benchmark times a single pad, build it with PADS=1.
+#endif
+#ifdef SERIAL_STREAM
+	#if defined(ALERT_WHEN_DONE) || defined(PROFILE_CHECK) || defined(CYCLE_PROFILE)
+		#error The serial stream uses the USART pins on PORTD, so it does not combine with ALERT_WHEN_DONE, PROFILE_CHECK or CYCLE_PROFILE.
+	#endif
+	// The host can start streaming as soon as we're up, it takes over at the start of the next match.
+	Stream_Init();
+#endif
+
+	// The macro programs and timing from the EEPROM profile replace the built-in ones, when there is a good one.
+	Profile_Load();
+
+#ifdef AUTO_TUNE
+	#ifdef RIVAL_ROTATION
+		#error Tuning changes how long a match takes as it goes, which RIVAL_ROTATION would take for the rivals being faster or slower.
+	#endif
+	#if PADS > 1 || defined(LATENCY_BENCH)
+		#error The auto-tuner follows a single pad playing matches, build it with PADS=1 and without LATENCY_BENCH.
+	#endif
+	#if defined(ALERT_WHEN_DONE) || defined(PROFILE_CHECK) || defined(CYCLE_PROFILE)
+		#error The auto-tuner reads a pin on PORTB, so it does not combine with ALERT_WHEN_DONE, PROFILE_CHECK or CYCLE_PROFILE.
+	#endif
+	// Tuning starts from the profile's scales, so it can carry on from an earlier run.
+	Tune_Init();
+#endif
+
 	// We can then initialize our hardware and peripherals, including the USB stack.
+	// The millisecond clock drives the macro timing, so it has to be running before the host starts polling us.
+	Clock_Init();
+
+#ifdef EVENT_TRACE
+	// The trace picks up where the run before the reset left it, if it survived.
+	Trace_Init(Counters.ResetCause, Unflagged);
+#endif
 
+#ifdef CYCLE_PROFILE
+	#if defined(ALERT_WHEN_DONE) || defined(PROFILE_CHECK)
+		#error The profiling build drives PORTB and PORTD pins itself, so it does not combine with ALERT_WHEN_DONE or PROFILE_CHECK.
+	#endif
+#warning Profiling enabled. PORTD pins 0 to 3 are high while each probe runs, PORTB pin 0 toggles on every missed or late IN poll.
+	Probe_Init();
+#endif
 #ifdef ALERT_WHEN_DONE
 	// Both PORTD and PORTB will be used for the optional LED flashing and buzzer.
-#warning LED and Buzzer functionality enabled. All pins on both PORTB and PORTD will toggle when printing is done.
+#warning LED and Buzzer functionality enabled. All pins on both PORTB and PORTD will toggle once the match target is reached.
 	DDRD = 0xFF; //Teensy uses PORTD
 	PORTD = 0x0;
 	//We'll just flash all pins on both ports since the UNO R3
@@ -94,20 +590,87 @@ void SetupHardware(void)
 	PORTB = 0x0; //The ATmega328P on the UNO will be resetting, so unplug it?
 #endif
 
+#ifdef PROFILE_CHECK
+	// The same pins show whether the console accepted our timing profile.
+#warning Timing profile check enabled. All pins on both PORTB and PORTD stay high if the console polls at POLLING_MS, and toggle every macro cycle if not.
+	DDRD = 0xFF;
+	PORTD = 0x0;
+	DDRB = 0xFF;
+	PORTB = 0x0;
+#endif
+
 	// The USB stack should be initialized last.
 	USB_Init();
+
+	// From here on the watchdog is fed by every report the host takes (see HID_Task()).
+	wdt_enable(WATCHDOG_TIMEOUT);
 }
 
 // Fired to indicate that the device is enumerating.
 void EVENT_USB_Device_Connect(void)
 {
 	// We can indicate that we're enumerating here (via status LEDs, sound, etc.).
+	TRACE(TRACE_CONNECT, 0, 0);
 }
 
 // Fired to indicate that the device is no longer connected to a host.
 void EVENT_USB_Device_Disconnect(void)
 {
 	// We can indicate that our device is not ready (via status LEDs, sound, etc.).
+	TRACE(TRACE_DISCONNECT, 0, 0);
+}
+
+// Fired when the host suspends the bus, e.g. when the console goes to sleep.
+void EVENT_USB_Device_Suspend(void)
+{
+	// Nobody is polling us now, and when we sleep between interrupts nothing would be left to feed the watchdog.
+	wdt_disable();
+	TRACE(TRACE_SUSPEND, 0, 0);
+}
+
+// Fired when the host resumes the bus after a suspend.
+void EVENT_USB_Device_WakeUp(void)
+{
+	wdt_enable(WATCHDOG_TIMEOUT);
+	TRACE(TRACE_WAKEUP, 0, 0);
+}
+
+// Starts the controller sync sequence of every pad over, once the host has (re)configured us. Pads that
+// are done stay connected without pressing anything.
+static void resyncPads(void)
+{
+	const Clock_ms_t Now = Clock_Millis();
+#ifndef FIXED_SYNC
+	// Polls from before the reset say nothing about whether the console has accepted us this time.
+	HostTiming.SteadyPolls = 0;
+#endif
+	for (uint8_t Pad = 0; Pad < PADS; Pad++)
+	{
+		Engine_t* const Engine = &engines[Pad];
+
+		// A program the host interrupted is where a desync most likely starts.
+		if (Engine->State == PROCESS || Engine->State == RECOVER || Engine->State == STREAM)
+			traceCut(Engine);
+		if (Engine->State != DONE)
+			setState(Engine, SYNC_CONTROLLER);
+		Engine->StateStarted = Now;
+#ifdef FRAME_CLOCK
+		polled_at[Pad]       = Now;
+#endif
+		ReportQueue_Init(&queues[Pad]);
+#ifndef FIXED_SYNC
+		Engine->SyncPress = SYNC_WAITING;
+		Engine->SyncOuts  = 0;
+#endif
+#ifdef QUICK_PASS
+		// The sync presses L and A wherever the console is, so a match that carries on can't rely on the cursor.
+		Engine->OnPass = false;
+#endif
+#ifdef RIVAL_ROTATION
+		// However long the console kept us waiting, it wasn't the rival's doing.
+		Rival_Untimed(&rivals[Pad]);
+#endif
+	}
 }
 
 // Fired when the host set the current configuration of the USB device after enumeration.
@@ -115,12 +678,48 @@ void EVENT_USB_Device_ConfigurationChanged(void)
 {
 	bool ConfigSuccess = true;
 
-	// We setup the HID report endpoints.
-	ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_OUT_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
-	ConfigSuccess &= Endpoint_ConfigureEndpoint(JOYSTICK_IN_EPADDR, EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
+#if defined(INTERRUPT_DRIVEN) || defined(FRAME_CLOCK)
+	// No endpoint is serviced from the start of frame interrupt while they are being set up again.
+	USB_Device_DisableSOFEvents();
+#endif
+
+	// The main loop starts the pads over between two reports (see FillReportQueue()), as we may have
+	// interrupted it in the middle of one. Until then, HID_Task() leaves the endpoints alone.
+	configurations++;
+	Counters.Syncs++;
+	for (uint8_t Pad = 0; Pad < PADS; Pad++)
+	{
+		// We setup the HID report endpoints, in ascending order of their numbers as the endpoint memory is laid out.
+		ConfigSuccess &= Endpoint_ConfigureEndpoint(PAD_IN_EPADDR(Pad), EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
+		ConfigSuccess &= Endpoint_ConfigureEndpoint(PAD_OUT_EPADDR(Pad), EP_TYPE_INTERRUPT, JOYSTICK_EPSIZE, 1);
+	}
 
 	// We can read ConfigSuccess to indicate a success or failure at this point.
+#ifdef EVENT_TRACE
+	Trace_Configured(ConfigSuccess, Clock_Millis());
+#endif
+
+#if defined(INTERRUPT_DRIVEN) || defined(FRAME_CLOCK)
+	// The endpoints will be serviced from the 1 ms start of frame interrupt from now on, and the clock follows it.
+	USB_Device_EnableSOFEvents();
+#endif
+}
+
+#if defined(INTERRUPT_DRIVEN) || defined(FRAME_CLOCK)
+// Fired once per USB frame, every millisecond, while the host keeps the bus active.
+void EVENT_USB_Device_StartOfFrame(void)
+{
+#ifdef FRAME_CLOCK
+	// The frame is counted first, so the reports serviced below are stamped with it.
+	Clock_Frame();
+#endif
+#ifdef INTERRUPT_DRIVEN
+	PROBE_BEGIN(PROBE_HID_TASK);
+	HID_Task();
+	PROBE_END(PROBE_HID_TASK);
+#endif
 }
+#endif
 
 // Process control requests sent to the device from the USB host.
 void EVENT_USB_Device_ControlRequest(void)
@@ -128,17 +727,151 @@ void EVENT_USB_Device_ControlRequest(void)
 	// We can handle two control requests: a GetReport and a SetReport.
 
 	// Not used here, it looks like we don't receive control request from the Switch.
+
+	// We do answer our own vendor requests though, which a PC uses to read our throughput counters.
+	switch (USB_ControlRequest.bRequest)
+	{
+		case VENDOR_REQ_GetCounters:
+			if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE))
+			{
+				Counters_t Snapshot;
+
+				// The counters are also updated from interrupts in some builds, so we copy them out in one go.
+				ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+				{
+					Snapshot = Counters;
+				}
+				// With more than one pad, the state is the first one's.
+				Snapshot.State  = engines[0].State;
+				Snapshot.Uptime = Clock_Seconds();
+#ifdef RIVAL_ROTATION
+				Snapshot.Rival  = rivals[0].Current;
+#endif
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&Snapshot, MIN(sizeof(Snapshot), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+			}
+			break;
+
+		case VENDOR_REQ_ResetCounters:
+			if (USB_ControlRequest.bmRequestType == (REQDIR_HOSTTODEVICE | REQTYPE_VENDOR | REQREC_DEVICE))
+			{
+				Endpoint_ClearSETUP();
+
+				ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+				{
+					Counters.Syncs      = 0;
+					Counters.Reports    = 0;
+					Counters.Cycles     = 0;
+					Counters.Turns      = 0;
+					Counters.Recoveries = 0;
+				}
+#ifdef CYCLE_PROFILE
+				Probe_Reset();
+#endif
+#ifdef EVENT_TRACE
+				Trace_Reset();
+#endif
+
+				Endpoint_ClearStatusStage();
+			}
+			break;
+
+#ifdef LATENCY_BENCH
+		case VENDOR_REQ_GetBench:
+			if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE))
+			{
+				Bench_t Snapshot;
+
+				ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+				{
+					Snapshot = Bench;
+				}
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&Snapshot, MIN(sizeof(Snapshot), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+			}
+			break;
+#endif
+
+#ifdef CYCLE_PROFILE
+		case VENDOR_REQ_GetProbes:
+			if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE))
+			{
+				Probes_t Snapshot;
+
+				ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+				{
+					Snapshot = Probes;
+				}
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&Snapshot, MIN(sizeof(Snapshot), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+			}
+			break;
+#endif
+
+#ifdef EVENT_TRACE
+		case VENDOR_REQ_GetTrace:
+			if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE))
+			{
+				// The ring is too big to copy on the 16u2's stack, so recording pauses while it goes out instead.
+				Trace_Hold(true);
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&Trace, MIN(sizeof(Trace), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+
+				Trace_Hold(false);
+			}
+			break;
+#endif
+
+		case VENDOR_REQ_WriteProfile:
+			if (USB_ControlRequest.bmRequestType == (REQDIR_HOSTTODEVICE | REQTYPE_VENDOR | REQREC_DEVICE) &&
+			    USB_ControlRequest.wLength <= PROFILE_CHUNK_SIZE)
+			{
+				uint8_t Chunk[PROFILE_CHUNK_SIZE];
+
+				Endpoint_ClearSETUP();
+				Endpoint_Read_Control_Stream_LE(Chunk, USB_ControlRequest.wLength);
+
+				// Nothing may start from the profile while it's half written. It is only used again once the host has it loaded.
+				Profile_Unload();
+				profile_changed = true;
+
+				// A chunk that doesn't fit is refused, so the host knows the profile wasn't written.
+				if (Profile_Write(USB_ControlRequest.wValue, Chunk, USB_ControlRequest.wLength))
+					Endpoint_ClearStatusStage();
+				else
+					Endpoint_StallTransaction();
+			}
+			break;
+
+		case VENDOR_REQ_LoadProfile:
+			if (USB_ControlRequest.bmRequestType == (REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE))
+			{
+				uint8_t Status = Profile_Load();
+				profile_changed = true;
+
+				Endpoint_ClearSETUP();
+				Endpoint_Write_Control_Stream_LE(&Status, MIN(sizeof(Status), USB_ControlRequest.wLength));
+				Endpoint_ClearOUT();
+			}
+			break;
+	}
 }
 
-// Process and deliver data from IN and OUT endpoints.
-void HID_Task(void)
+// Process and deliver data from the IN and OUT endpoints of one pad.
+static void padTask(const uint8_t Pad)
 {
-	// If the device isn't connected and properly configured, we can't do anything here.
-	if (USB_DeviceState != DEVICE_STATE_Configured)
-		return;
+	ReportQueue_t* const Queue = &queues[Pad];
 
 	// We'll start with the OUT endpoint.
-	Endpoint_SelectEndpoint(JOYSTICK_OUT_EPADDR);
+	Endpoint_SelectEndpoint(PAD_OUT_EPADDR(Pad));
 	// We'll check to see if we received something on the OUT endpoint.
 	if (Endpoint_IsOUTReceived())
 	{
@@ -150,161 +883,281 @@ void HID_Task(void)
 			// We'll then take in that data, setting it up in our storage.
 			Endpoint_Read_Stream_LE(&JoystickOutputData, sizeof(JoystickOutputData), NULL);
 			// At this point, we can react to this data.
-
-			// However, since we're not doing anything with this data, we abandon it.
+#ifndef FIXED_SYNC
+			// The console has registered this pad, which the fast sync looks for.
+			if (engines[Pad].SyncOuts < UINT8_MAX)
+				engines[Pad].SyncOuts++;
+#endif
+#ifdef HOST_TIMING
+			// We only care about when it arrived, so the sync and host paced waits in the macro can finish early. The
+			// console treats every pad alike, so the first one's traffic stands for all of them.
+			if (Pad == 0)
+				Host_RecordOUT(Clock_Millis());
+#endif
+#ifdef LATENCY_BENCH
+			// The console mirrors what it has seen of us, which closes a press's round trip.
+			Bench_RecordOUT(&JoystickOutputData);
+#endif
+			// Otherwise, since we're not doing anything with this data, we abandon it.
 		}
 		// Regardless of whether we reacted to the data, we acknowledge an OUT packet on this endpoint.
 		Endpoint_ClearOUT();
 	}
 
 	// We'll then move on to the IN endpoint.
-	Endpoint_SelectEndpoint(JOYSTICK_IN_EPADDR);
+	Endpoint_SelectEndpoint(PAD_IN_EPADDR(Pad));
 	// We first check to see if the host is ready to accept data.
-	if (Endpoint_IsINReady())
+#ifdef CYCLE_PROFILE
+	if (Pad == 0)
+		Probe_Poll(Endpoint_IsINReady(), !ReportQueue_IsStarved(Queue), Clock_Millis());
+#endif
+	if (Endpoint_IsINReady() && !ReportQueue_IsEmpty(Queue))
 	{
-		// We'll create an empty report.
-		USB_JoystickReport_Input_t JoystickInputData;
-		// We'll then populate this report with what we want to send to the host.
-		GetNextReport(&JoystickInputData);
-		// Once populated, we can output this data to the host. We do this by first writing the data to the control stream.
-		Endpoint_Write_Stream_LE(&JoystickInputData, sizeof(JoystickInputData), NULL);
+#ifdef CYCLE_PROFILE
+		if (Pad == 0)
+			Probe_RecordIN(Clock_Millis());
+#endif
+#ifdef FRAME_CLOCK
+		polled_at[Pad] = Clock_Millis();
+#endif
+#ifdef EVENT_TRACE
+		Trace_RecordIN(Pad, Clock_Millis());
+#endif
+#ifdef HOST_TIMING
+		// The bank only frees up once the host has taken our last report, so this is effectively its poll time.
+		if (Pad == 0)
+			Host_RecordIN(Clock_Millis());
+#endif
+		// The next report is already built, so we can output it to the host straight away. We do this by first writing the data to the control stream.
+		const USB_JoystickReport_Input_t* Report = ReportQueue_Next(Queue);
+		Endpoint_Write_Stream_LE(Report, sizeof(USB_JoystickReport_Input_t), NULL);
+#ifdef LATENCY_BENCH
+		Bench_RecordIN(Report);
+#endif
 		// We then send an IN packet on this endpoint.
 		Endpoint_ClearIN();
+		Counters.Reports++;
+		// The host is still taking our reports, so we aren't stuck.
+		wdt_reset();
 	}
 }
 
-typedef enum {
-	SYNC_CONTROLLER,
-	BREATHE,
-	PROCESS
-} State_t;
-State_t state = SYNC_CONTROLLER;
-
-#define ECHOES 2
-#define TURNS 12
-int echoes = 0;
-USB_JoystickReport_Input_t last_report;
-
-int command_count = 0;
-int report_count = 0;
-int xpos = 0;
-int ypos = 0;
-int bufindex = 0;
-int duration_count = 0;
-int portsval = 0;
-int turn_count = 0;
-
-#define max(a, b) (a > b ? a : b)
-#define ms_2_count(ms) (ms / ECHOES / (max(POLLING_MS, 8) / 8 * 8))
-
-void processCommand(USB_JoystickReport_Input_t *const ReportData, command cmd)
+// Process and deliver data from IN and OUT endpoints.
+void HID_Task(void)
 {
-	switch (cmd.button)
-	{
-		case UP:
-			ReportData->HAT = HAT_TOP;				
-			break;
+	// If the device isn't connected and properly configured, we can't do anything here. Nor can we while the
+	// pads haven't been started over since the host last configured us.
+	if (USB_DeviceState != DEVICE_STATE_Configured || configurations != configurations_seen)
+		return;
 
-		case LEFT:
-			ReportData->HAT = HAT_LEFT;				
-			break;
+	// We may have interrupted code that is talking to another endpoint, so we'll put its selection back afterwards.
+	uint8_t PrevEndpoint = Endpoint_GetCurrentEndpoint();
 
-		case DOWN:
-			ReportData->HAT = HAT_BOTTOM;				
-			break;
-
-		case RIGHT:
-			ReportData->HAT = HAT_RIGHT;				
-			break;
+	for (uint8_t Pad = 0; Pad < PADS; Pad++)
+		padTask(Pad);
 
-		case A:
-			ReportData->Button |= SWITCH_A;
-			break;
-			
-		case B:
-			ReportData->Button |= SWITCH_B;
-			break;
+	Endpoint_SelectEndpoint(PrevEndpoint);
+}
 
-		default:
-			ReportData->LX = STICK_CENTER;
-			ReportData->LY = STICK_CENTER;
-			ReportData->RX = STICK_CENTER;
-			ReportData->RY = STICK_CENTER;
-			ReportData->HAT = HAT_CENTER;
-			break;
+// Top up the report queue with the reports that follow the ones already queued.
+void FillReportQueue(void)
+{
+	// Until the host has configured us there's nobody to send reports to, and the sync sequence hasn't started.
+	// With nobody polling us there is nothing to feed the watchdog in HID_Task() either, so we do it here.
+	if (USB_DeviceState != DEVICE_STATE_Configured)
+	{
+		wdt_reset();
+		return;
 	}
 
-	duration_count++;
-
-	if (duration_count > cmd.duration)
+	// The host's (re)configuration is taken in here, between two reports. Should it configure us again while
+	// we're at it, the counts still differ afterwards and the pads are started over once more.
+	const uint8_t Configurations = configurations;
+	if (Configurations != configurations_seen)
 	{
-		bufindex++;
-		duration_count = 0;				
+		resyncPads();
+		configurations_seen = Configurations;
+	}
+	if (profile_changed)
+	{
+		profile_changed = false;
+		stopProfilePrograms();
 	}
-}	
 
+	for (uint8_t Pad = 0; Pad < PADS; Pad++)
+	{
+		ReportQueue_t* const Queue = &queues[Pad];
 
-// Prepare the next report for the host
-void GetNextReport(USB_JoystickReport_Input_t *const ReportData)
+		while (!ReportQueue_IsFull(Queue))
+		{
+			PROBE_BEGIN(PROBE_NEXT_REPORT);
+			GetNextReport(Pad, ReportQueue_Reserve(Queue));
+			PROBE_END(PROBE_NEXT_REPORT);
+			// Every report is sent once, then repeated ECHOES more times (see Config/Timing.h). The benchmark tries several counts.
+#ifdef LATENCY_BENCH
+			ReportQueue_Commit(Queue, 1 + Bench_Echoes());
+#else
+			ReportQueue_Commit(Queue, 1 + ECHOES);
+#endif
+		}
+	}
+}
+
+// Runs the current program up to now, into the report.
+static bool runMacro(Engine_t* const Engine, USB_JoystickReport_Input_t* const ReportData)
 {
+	PROBE_BEGIN(PROBE_MACRO_RUN);
+	bool Running = Macro_Run(&Engine->Macro, ReportData, report_time);
+	PROBE_END(PROBE_MACRO_RUN);
 
-	// Prepare an empty report
-	memset(ReportData, 0, sizeof(USB_JoystickReport_Input_t));
-	ReportData->LX = STICK_CENTER;
-	ReportData->LY = STICK_CENTER;
-	ReportData->RX = STICK_CENTER;
-	ReportData->RY = STICK_CENTER;
-	ReportData->HAT = HAT_CENTER;
+	return Running;
+}
 
-	// Repeat ECHOES times the last report
-	if (echoes > 0)
+// Prepare the next report of a pad for the host
+void GetNextReport(const uint8_t Pad, USB_JoystickReport_Input_t *const ReportData)
+{
+	Engine_t* const Engine = &engines[Pad];
+
+#ifdef FRAME_CLOCK
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		memcpy(ReportData, &last_report, sizeof(USB_JoystickReport_Input_t));
-		echoes--;
-		return;
+		report_time = polled_at[Pad];
 	}
+#else
+	report_time = Clock_Millis();
+#endif
 
-	// States and moves management
-	switch (state)
+	// States and moves management. The macro interpreter writes whole reports, the other states start
+	// from an empty one.
+	switch (Engine->State)
 	{
 		case SYNC_CONTROLLER:
-			if (command_count > ms_2_count(2000))
+			memcpy_P(ReportData, &neutral_report, sizeof(USB_JoystickReport_Input_t));
+#ifdef FIXED_SYNC
+			if (fixedSync(ReportData, report_time - Engine->StateStarted))
+#else
+			if (fastSync(Engine, ReportData, report_time))
+#endif
 			{
-				command_count = 0;
-				state = BREATHE;
+				// After a watchdog reset we can't know which screen the console is on, so we find our way back first.
+				if (Engine->Lost)
+					startRecovery(Engine);
+				else
+					setState(Engine, BREATHE);
 			}
-			else
+			break;
+		case BREATHE:
+			memcpy_P(ReportData, &neutral_report, sizeof(USB_JoystickReport_Input_t));
+#ifdef SERIAL_STREAM
+			// Once the host has sent something, its stream plays the next match on the first pad instead of the built-in programs.
+			if (Pad == 0 && Stream_Count())
 			{
-				if (command_count == ms_2_count(500) || command_count == ms_2_count(1000))
-					ReportData->Button |= SWITCH_L;
-				else if (command_count == ms_2_count(1500) || command_count == ms_2_count(2000))
-					ReportData->Button |= SWITCH_A;
-				command_count++;
+				setState(Engine, STREAM);
+				Macro_Start(&Engine->Macro, MACRO_STREAM, NULL, report_time);
+				break;
 			}
+#endif
+#ifdef LATENCY_BENCH
+			// Benchmark builds measure instead of playing, and stop once the table is complete.
+			setState(Engine, BENCH);
+			Bench_Start(report_time);
 			break;
-		case BREATHE:
-			state = PROCESS;
+#endif
+#ifdef PROFILE_CHECK
+			// The pins show the host's timing, which every pad shares, so they only follow the first one's matches.
+			if (Pad == 0)
+				checkTimingProfile();
+#endif
+			setState(Engine, PROCESS);
+			startProgram(Engine, phaseSlot(Engine), false);
 			break;
 		case PROCESS:
-			processCommand(ReportData, step[bufindex]);
-			if (bufindex > (int)( sizeof(step) / sizeof(step[0])) - 1)
+#ifdef AUTO_TUNE
+			// The operator saw the game miss a press, which has most likely left it on the wrong screen too.
+			if (Tune_Dropped(report_time))
 			{
-				bufindex = 0;
-				duration_count = 0;
-
-				state = BREATHE;
-
-				ReportData->LX = STICK_CENTER;
-				ReportData->LY = STICK_CENTER;
-				ReportData->RX = STICK_CENTER;
-				ReportData->RY = STICK_CENTER;
-				ReportData->HAT = HAT_CENTER;
+				traceCut(Engine);
+				startRecovery(Engine);
+				runMacro(Engine, ReportData);
+				break;
+			}
+#endif
+			if (!runMacro(Engine, ReportData))
+			{
+				if (nextPhase(Engine))
+				{
+					Counters.Cycles++;
+#ifdef AUTO_TUNE
+					Tune_MatchPlayed();
+#endif
+					if (targetReached(Engine))
+					{
+						finish(Engine);
+						break;
+					}
+					if (recoveryDue(Engine))
+					{
+						startRecovery(Engine);
+						break;
+					}
+#ifdef SERIAL_STREAM
+					// A stream waiting to take over starts after a breath, pipelining or not.
+					if (Pad == 0 && Stream_Count())
+					{
+						setState(Engine, BREATHE);
+						break;
+					}
+#endif
+#ifndef MACRO_PIPELINE
+					// Once the match is over, we take a breath and start the next one.
+					setState(Engine, BREATHE);
+					break;
+#endif
+				}
+				// The next phase starts in this very report. When pipelining, so does the next match.
+				startProgram(Engine, phaseSlot(Engine), true);
+				runMacro(Engine, ReportData);
 			}
 			break;
-
+		case RECOVER:
+			// Once we're back on a known screen, the next match starts after a breath.
+			if (!runMacro(Engine, ReportData))
+				setState(Engine, BREATHE);
+			break;
+#ifdef SERIAL_STREAM
+		case STREAM:
+			// The host's program ends with END, on the deck select screen, and the next match starts after a breath.
+			// If the stream stalls instead, we can't know which screen it left us on, so we find our way back first.
+			if (!runMacro(Engine, ReportData))
+			{
+				if (Engine->Macro.Stalled)
+				{
+					traceCut(Engine);
+					Stream_Flush();
+					startRecovery(Engine);
+				}
+				else
+				{
+					setState(Engine, BREATHE);
+				}
+			}
+			break;
+#endif
+#ifdef LATENCY_BENCH
+		case BENCH:
+			memcpy_P(ReportData, &neutral_report, sizeof(USB_JoystickReport_Input_t));
+			if (!Bench_NextReport(ReportData, report_time))
+				finish(Engine);
+			break;
+#endif
+		case DONE:
+			// Nothing is pressed any more, the console just sees an idle controller.
+			memcpy_P(ReportData, &neutral_report, sizeof(USB_JoystickReport_Input_t));
+#ifdef ALERT_WHEN_DONE
+			// Once every pad is done, the LEDs flash and the buzzer beeps twice a second.
+			if (allDone())
+				PORTB = PORTD = (Clock_Millis() & 0x100) ? 0xFF : 0x00;
+#endif
+			break;
 	}
-
-	// Prepare to echo this report
-	memcpy(&last_report, ReportData, sizeof(USB_JoystickReport_Input_t));
-	echoes = ECHOES;
 }
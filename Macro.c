@@ -0,0 +1,334 @@
+/** \file
+ *
+ *  Interpreter for the macro bytecode described in Macro.h.
+ */
+
+#include "Macro.h"
+
+MacroTiming_t MacroTiming = {
+	.PressScale   = 100,
+	.ReleaseScale = 100,
+};
+
+// The whole report each input holds, so a step is applied with a single copy. Sticks stay centered unless held by MOP_STICK.
+#define INPUT_REPORT(button, hat) { .Button = (button), .HAT = (hat), .LX = STICK_CENTER, .LY = STICK_CENTER, .RX = STICK_CENTER, .RY = STICK_CENTER }
+
+static const USB_JoystickReport_Input_t PROGMEM Macro_Inputs[MACRO_INPUTS] = {
+	[UP]      = INPUT_REPORT(0,        HAT_TOP),
+	[DOWN]    = INPUT_REPORT(0,        HAT_BOTTOM),
+	[LEFT]    = INPUT_REPORT(0,        HAT_LEFT),
+	[RIGHT]   = INPUT_REPORT(0,        HAT_RIGHT),
+	[A]       = INPUT_REPORT(SWITCH_A, HAT_CENTER),
+	[B]       = INPUT_REPORT(SWITCH_B, HAT_CENTER),
+	[NOTHING] = INPUT_REPORT(0,        HAT_CENTER),
+	[A_UP]    = INPUT_REPORT(SWITCH_A, HAT_TOP),
+	[A_DOWN]  = INPUT_REPORT(SWITCH_A, HAT_BOTTOM),
+	[A_LEFT]  = INPUT_REPORT(SWITCH_A, HAT_LEFT),
+	[A_RIGHT] = INPUT_REPORT(SWITCH_A, HAT_RIGHT),
+	[B_UP]    = INPUT_REPORT(SWITCH_B, HAT_TOP),
+	[B_DOWN]  = INPUT_REPORT(SWITCH_B, HAT_BOTTOM),
+	[B_LEFT]  = INPUT_REPORT(SWITCH_B, HAT_LEFT),
+	[B_RIGHT] = INPUT_REPORT(SWITCH_B, HAT_RIGHT),
+};
+
+// Reads a byte of the program, from wherever it is stored. Streamed instructions are read from Fetched.
+static uint8_t Macro_Read(const Macro_t* const Macro, const uint8_t* const Address)
+{
+#ifdef SERIAL_STREAM
+	if (Macro->Source == MACRO_STREAM)
+		return *Address;
+#endif
+	return (Macro->Source == MACRO_EEPROM) ? eeprom_read_byte(Address) : pgm_read_byte(Address);
+}
+
+// Returns the size in bytes of the instruction starting with the given byte.
+static uint8_t Macro_InstructionLength(const uint8_t Op)
+{
+	if ((Op >> 4) != MACRO_INPUT_RESERVED)
+		return (Op & 0x0F) ? 1 : 2;
+
+	switch (Op & 0x0F)
+	{
+		case MOP_REPEAT:
+		case MOP_LABEL:
+		case MOP_JUMP:
+		case MOP_HAT:
+		case MOP_COUNT:
+			return 2;
+		case MOP_WAIT:
+		case MOP_PRESS:
+		case MOP_WAIT_SETTLE:
+		case MOP_WAIT_CHANGE:
+		case MOP_WAIT_OUT:
+			return 3;
+		case MOP_STICK:
+			return 4;
+		default:
+			return 1;
+	}
+}
+
+#ifdef MACRO_PIPELINE
+// Returns true if two inputs share a button or a direction, so the console only sees the second press after a release.
+static bool Macro_Overlaps(const uint8_t First, const uint8_t Second)
+{
+	uint8_t HAT = pgm_read_byte(&Macro_Inputs[First].HAT);
+
+	return (pgm_read_word(&Macro_Inputs[First].Button) & pgm_read_word(&Macro_Inputs[Second].Button)) ||
+	       (HAT != HAT_CENTER && HAT == pgm_read_byte(&Macro_Inputs[Second].HAT));
+}
+#endif
+
+#ifdef SERIAL_STREAM
+// Takes the streamed instruction at the given PC out of the FIFO into Fetched, unless it's already there.
+// Returns false while the host hasn't sent all of it yet.
+static bool Macro_Fetch(Macro_t* const Macro, const uint16_t At)
+{
+	if (Macro->FetchedPC == At)
+		return true;
+
+	if (!Stream_Count())
+		return false;
+
+	uint8_t Length = Macro_InstructionLength(Stream_Peek(0));
+	if (Stream_Count() < Length)
+		return false;
+
+	for (uint8_t Byte = 0; Byte < Length; Byte++)
+		Macro->Fetched[Byte] = Stream_Peek(Byte);
+	Stream_Drop(Length);
+
+	Macro->FetchedPC = At;
+	return true;
+}
+#endif
+
+// Scales a hold time by the given percentage.
+static uint16_t Macro_Scale(const uint16_t MS, const uint8_t Percent)
+{
+	return (Percent == 100) ? MS : (uint16_t)(((uint32_t)MS * Percent) / 100);
+}
+
+// Finds the offset of the instruction following the given label, or returns false if there isn't one.
+static bool Macro_FindLabel(const Macro_t* const Macro, const uint8_t Id, uint16_t* const PC)
+{
+	uint16_t Offset = 0;
+
+	for (;;)
+	{
+		uint8_t Op = Macro_Read(Macro, &Macro->Program[Offset]);
+
+		if (Op == MACRO_OP(MOP_END))
+			return false;
+
+		if (Op == MACRO_OP(MOP_LABEL) && Macro_Read(Macro, &Macro->Program[Offset + 1]) == Id)
+		{
+			*PC = Offset + 2;
+			return true;
+		}
+
+		Offset += Macro_InstructionLength(Op);
+	}
+}
+
+// Lets go of both sticks.
+static void Macro_CenterSticks(Macro_t* const Macro)
+{
+	for (uint8_t Stick = MACRO_STICK_LEFT; Stick <= MACRO_STICK_RIGHT; Stick++)
+	{
+		Macro->HeldSticks[Stick].X = STICK_CENTER;
+		Macro->HeldSticks[Stick].Y = STICK_CENTER;
+	}
+}
+
+// Writes a report with nothing pressed, for a program that has ended. Always returns false.
+static bool Macro_Ended(USB_JoystickReport_Input_t* const ReportData)
+{
+	memcpy_P(ReportData, &Macro_Inputs[NOTHING], sizeof(USB_JoystickReport_Input_t));
+	return false;
+}
+
+void Macro_Start(Macro_t* const Macro, const MacroSource_t Source, const uint8_t* const Program, const Clock_ms_t Now)
+{
+	Macro->StepStarted  = Now;
+	Macro->StepDuration = 0;
+	Macro->StepInput    = NOTHING;
+	Macro->StepWait     = MACRO_NO_WAIT;
+
+	Macro_Chain(Macro, Source, Program);
+}
+
+void Macro_Chain(Macro_t* const Macro, const MacroSource_t Source, const uint8_t* const Program)
+{
+	Macro->Program     = Program;
+	Macro->Source      = Source;
+	Macro->PC          = 0;
+	Macro->StepPC      = 0;
+	Macro->HeldButtons = 0;
+	Macro->HeldHAT     = HAT_CENTER;
+	Macro_CenterSticks(Macro);
+	Macro->Depth       = 0;
+#ifdef SERIAL_STREAM
+	Macro->FetchedPC   = UINT16_MAX;
+	Macro->Stalled     = false;
+#endif
+}
+
+bool Macro_Run(Macro_t* const Macro, USB_JoystickReport_Input_t* const ReportData, const Clock_ms_t Now)
+{
+	uint8_t Budget = MACRO_MAX_OPS;
+
+#ifdef HOST_PACING
+	// A host paced wait finishes as soon as the host does what it was waiting for.
+	if (Macro->StepWait != MACRO_NO_WAIT && Host_WaitDone(Macro->StepWait, Macro->StepSnapshot, Now))
+		Macro->StepDuration = 0;
+#endif
+
+	// We fetch instructions until we reach one that is still running at this time. Untimed
+	// instructions all run back to back, but we stop early if a program loops without waiting.
+	while ((Clock_ms_t)(Now - Macro->StepStarted) >= Macro->StepDuration && Budget--)
+	{
+		const uint16_t At      = Macro->PC;
+		const uint8_t* Address = &Macro->Program[At];
+#ifdef SERIAL_STREAM
+		if (Macro->Source == MACRO_STREAM)
+		{
+			// Nothing is pressed while we wait for the host's next instruction, and if it doesn't come the program is over.
+			if (!Macro_Fetch(Macro, At))
+			{
+				if (Stream_Stalled())
+				{
+					Macro->Stalled = true;
+					return Macro_Ended(ReportData);
+				}
+
+				Macro->StepInput = NOTHING;
+				break;
+			}
+			Address = Macro->Fetched;
+		}
+#endif
+		uint8_t Op = Macro_Read(Macro, Address);
+
+		Macro->PC += Macro_InstructionLength(Op);
+		Macro->StepWait = MACRO_NO_WAIT;
+
+		// Input steps hold their input for the encoded number of ticks.
+		if ((Op >> 4) != MACRO_INPUT_RESERVED)
+		{
+#ifdef MACRO_PIPELINE
+			// Separators are dropped, we only release between two presses of the same input.
+			if ((Op >> 4) == NOTHING)
+				continue;
+
+			if (Macro_Overlaps(Op >> 4, Macro->StepInput))
+			{
+				// We'll come back to this step once the gap is over.
+				Macro->PC           = At;
+				Macro->StepPC       = At;
+				Macro->StepInput    = NOTHING;
+				Macro->StepDuration = RELEASE_GAP_MS;
+				Macro->StepStarted  = Now;
+				continue;
+			}
+#endif
+			Macro->StepPC       = At;
+			Macro->StepInput    = Op >> 4;
+			Macro->StepDuration = Macro_Scale((uint16_t)((Op & 0x0F) ? (Op & 0x0F) : Macro_Read(Macro, Address + 1)) * MACRO_TICK_MS,
+			                                  ((Op >> 4) == NOTHING) ? MacroTiming.ReleaseScale : MacroTiming.PressScale);
+			Macro->StepStarted  = Now;
+			continue;
+		}
+
+		switch (Op & 0x0F)
+		{
+			case MOP_END:
+				Macro->PC -= 1;
+				return Macro_Ended(ReportData);
+
+			case MOP_REPEAT:
+				// A streamed program can't go back to the start of a block, so MOP_LOOP finds none open.
+				if (Macro->Depth < MACRO_MAX_DEPTH && Macro->Source != MACRO_STREAM)
+				{
+					Macro->Loops[Macro->Depth].Start = Macro->PC;
+					Macro->Loops[Macro->Depth].Count = Macro_Read(Macro, Address + 1);
+					Macro->Depth++;
+				}
+				break;
+
+			case MOP_LOOP:
+				if (Macro->Depth > 0)
+				{
+					if (--Macro->Loops[Macro->Depth - 1].Count > 0)
+						Macro->PC = Macro->Loops[Macro->Depth - 1].Start;
+					else
+						Macro->Depth--;
+				}
+				break;
+
+			case MOP_JUMP:
+				// Jumping to a label that doesn't exist ends the program. Streamed programs can't jump.
+				if (Macro->Source != MACRO_STREAM && !Macro_FindLabel(Macro, Macro_Read(Macro, Address + 1), &Macro->PC))
+					return Macro_Ended(ReportData);
+				break;
+
+			case MOP_WAIT:
+				Macro->StepPC       = At;
+				Macro->StepInput    = NOTHING;
+				Macro->StepDuration = (uint16_t)(Macro_Read(Macro, Address + 1) | (Macro_Read(Macro, Address + 2) << 8)) * MACRO_TICK_MS;
+				Macro->StepStarted  = Now;
+				break;
+
+			case MOP_WAIT_SETTLE:
+			case MOP_WAIT_CHANGE:
+			case MOP_WAIT_OUT:
+				Macro->StepWait     = (Op & 0x0F) - MOP_WAIT_SETTLE + HOST_WAIT_SETTLE;
+				Macro->StepSnapshot = Host_Snapshot(Macro->StepWait);
+				Macro->StepPC       = At;
+				Macro->StepInput    = NOTHING;
+				Macro->StepDuration = (uint16_t)(Macro_Read(Macro, Address + 1) | (Macro_Read(Macro, Address + 2) << 8)) * MACRO_TICK_MS;
+				Macro->StepStarted  = Now;
+				break;
+
+			case MOP_PRESS:
+				Macro->HeldButtons |= Macro_Read(Macro, Address + 1) | (Macro_Read(Macro, Address + 2) << 8);
+				break;
+
+			case MOP_HAT:
+				Macro->HeldHAT = Macro_Read(Macro, Address + 1);
+				break;
+
+			case MOP_STICK:
+				// Stick numbers other than the two the report has are ignored.
+				if (Macro_Read(Macro, Address + 1) <= MACRO_STICK_RIGHT)
+				{
+					Macro->HeldSticks[Macro_Read(Macro, Address + 1)].X = Macro_Read(Macro, Address + 2);
+					Macro->HeldSticks[Macro_Read(Macro, Address + 1)].Y = Macro_Read(Macro, Address + 3);
+				}
+				break;
+
+			case MOP_RELEASE:
+				Macro->HeldButtons = 0;
+				Macro->HeldHAT     = HAT_CENTER;
+				Macro_CenterSticks(Macro);
+				break;
+
+			case MOP_COUNT:
+				Counters_Count(Macro_Read(Macro, Address + 1));
+				break;
+		}
+	}
+
+	// The report holds the input of the current step, plus whatever has been pressed. A direction
+	// of the step wins over the held HAT, and the sticks are whatever MOP_STICK holds.
+	memcpy_P(ReportData, &Macro_Inputs[Macro->StepInput], sizeof(USB_JoystickReport_Input_t));
+	ReportData->Button |= Macro->HeldButtons;
+	if (ReportData->HAT == HAT_CENTER)
+		ReportData->HAT = Macro->HeldHAT;
+	ReportData->LX = Macro->HeldSticks[MACRO_STICK_LEFT].X;
+	ReportData->LY = Macro->HeldSticks[MACRO_STICK_LEFT].Y;
+	ReportData->RX = Macro->HeldSticks[MACRO_STICK_RIGHT].X;
+	ReportData->RY = Macro->HeldSticks[MACRO_STICK_RIGHT].Y;
+
+	return true;
+}
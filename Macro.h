@@ -0,0 +1,194 @@
+/** \file
+ *
+ *  Macro bytecode stored in flash or EEPROM, and the interpreter that replays it.
+ *
+ *  Each input step is one byte: the input in the high nibble and its hold time in the
+ *  low nibble, counted in MACRO_TICK_MS units. Steps longer than 15 ticks store 0 in the
+ *  low nibble and the tick count in a second byte.
+ *
+ *  A high nibble of MACRO_INPUT_RESERVED marks a control opcode instead, with the
+ *  opcode in the low nibble followed by its operands (see MacroOpcodes_t).
+ *
+ *  With SERIAL_STREAM defined, a program can also come in over the USART (see Stream.h).
+ *  It is run an instruction at a time as it arrives, so REPEAT, LOOP, LABEL and JUMP
+ *  are ignored there and the host unrolls its loops itself.
+ *
+ *  With MACRO_PIPELINE defined, NOTHING steps are skipped and each press follows the
+ *  previous one straight away. A release of RELEASE_GAP_MS is only inserted between
+ *  two presses of the same input, so that the game sees both.
+ */
+
+#ifndef _MACRO_H_
+#define _MACRO_H_
+
+/* Includes: */
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Timing.h"
+#include "Report.h"
+#include "Clock.h"
+#include "Host.h"
+#include "Counters.h"
+#include "Stream.h"
+
+// Type Defines
+// Inputs a macro step can hold. These are stored in a nibble, so there can be at most 15.
+// The chords press a button and a direction in the same step. Each one's report is in Macro_Inputs[].
+typedef enum {
+	UP,
+	DOWN,
+	LEFT,
+	RIGHT,
+	A,
+	B,
+	NOTHING,
+	A_UP,
+	A_DOWN,
+	A_LEFT,
+	A_RIGHT,
+	B_UP,
+	B_DOWN,
+	B_LEFT,
+	B_RIGHT
+} Buttons_t;
+
+// Control opcodes, stored in the low nibble after MACRO_INPUT_RESERVED.
+typedef enum {
+	MOP_END,     // End of the program
+	MOP_REPEAT,  // [count] Run the instructions up to the matching MOP_LOOP count times
+	MOP_LOOP,    // End of a MOP_REPEAT block
+	MOP_LABEL,   // [id] Jump target, takes no time
+	MOP_JUMP,    // [id] Continue from the matching MOP_LABEL
+	MOP_WAIT,    // [ticks lo] [ticks hi] Keep the held inputs for a while
+	MOP_PRESS,   // [mask lo] [mask hi] Hold down any combination of JoystickButtons_t
+	MOP_HAT,     // [hat] Hold a HAT direction
+	MOP_RELEASE, // Let go of everything held by MOP_PRESS, MOP_HAT and MOP_STICK
+	MOP_WAIT_SETTLE, // [timeout lo] [timeout hi] Wait until the host polls at a steady cadence
+	MOP_WAIT_CHANGE, // [timeout lo] [timeout hi] Wait until the host's poll cadence changes
+	MOP_WAIT_OUT,    // [timeout lo] [timeout hi] Wait until the host sends an OUT report
+	MOP_COUNT,       // [id] Bump one of the CounterIds_t counters
+	MOP_STICK,       // [stick] [x] [y] Hold MACRO_STICK_LEFT or MACRO_STICK_RIGHT deflected
+	MOP_OPCODES,     // Number of opcodes, which have to fit in the low nibble
+} MacroOpcodes_t;
+
+// Where a program's bytecode is stored.
+typedef enum {
+	MACRO_FLASH,  // Built into the firmware (Macros.c)
+	MACRO_EEPROM, // Part of the EEPROM profile (see Profile.h)
+	MACRO_STREAM, // Taken from the serial stream as it arrives (see Stream.h), with no Program
+} MacroSource_t;
+
+// Scaling of step hold times, in percent. The EEPROM profile sets these, they are 100 otherwise.
+// Waits and pipelined release gaps aren't scaled.
+typedef struct {
+	uint8_t PressScale;   // Steps that hold an input
+	uint8_t ReleaseScale; // NOTHING steps
+} MacroTiming_t;
+
+// Phases of a match. Each one is played by its own macro program in Macros.c, timed for its screen.
+typedef enum {
+	PHASE_DECK_SELECT, // Pick the deck and answer the opening hand prompt
+	PHASE_TURN,        // Pass one turn, played TURNS times per match
+	PHASE_RESULTS,     // Skip through the match results
+	PHASE_POPUPS,      // Dismiss the level up and reward popups
+	PHASE_REMATCH,     // Accept the rematch prompt, which leads back to the deck select
+	PHASE_COUNT
+} Phase_t;
+
+// Macros
+// Input nibble value marking a control opcode.
+#define MACRO_INPUT_RESERVED 0x0F
+
+// Number of turns in a Tableturf match.
+#define TURNS 12
+
+// Step durations are stored in MACRO_TICK_MS units, which the timing profile sets.
+#define MACRO_TICKS(ms) (((ms) + MACRO_TICK_MS - 1) / MACRO_TICK_MS)
+
+// StepWait value for steps that only end on time.
+#define MACRO_NO_WAIT   0xFF
+
+// How deeply REPEAT blocks may be nested.
+#define MACRO_MAX_DEPTH 2
+// How many untimed instructions we'll run for a single report before handing control back.
+#define MACRO_MAX_OPS   16
+// Size of the longest instruction, in bytes.
+#define MACRO_MAX_INSTRUCTION 4
+
+// Sticks MOP_STICK can hold.
+#define MACRO_STICK_LEFT  0
+#define MACRO_STICK_RIGHT 1
+
+// Number of inputs a step can hold, see Buttons_t.
+#define MACRO_INPUTS    MACRO_INPUT_RESERVED
+
+// Bytecode helpers, used to write macro tables.
+// A one byte step, held for up to 15 ticks. Longer durations fail to compile.
+#define TAP(input, ms)  (uint8_t)(((input) << 4) | MACRO_TICKS(ms) | 0 * sizeof(char[(MACRO_TICKS(ms) >= 1 && MACRO_TICKS(ms) <= 0x0F) ? 1 : -1]))
+// A two byte step, held for up to 255 ticks.
+#define HOLD(input, ms) (uint8_t)((input) << 4), (uint8_t)(MACRO_TICKS(ms) | 0 * sizeof(char[(MACRO_TICKS(ms) >= 1 && MACRO_TICKS(ms) <= 0xFF) ? 1 : -1]))
+
+#define MACRO_OP(op)    (uint8_t)((MACRO_INPUT_RESERVED << 4) | (op))
+#define END             MACRO_OP(MOP_END)
+#define REPEAT(count)   MACRO_OP(MOP_REPEAT), (uint8_t)(count)
+#define LOOP            MACRO_OP(MOP_LOOP)
+#define LABEL(id)       MACRO_OP(MOP_LABEL), (uint8_t)(id)
+#define JUMP(id)        MACRO_OP(MOP_JUMP), (uint8_t)(id)
+#define WAIT_MS(ms)     MACRO_OP(MOP_WAIT), (uint8_t)MACRO_TICKS(ms), (uint8_t)(MACRO_TICKS(ms) >> 8)
+#define PRESS(mask)     MACRO_OP(MOP_PRESS), (uint8_t)(mask), (uint8_t)((mask) >> 8)
+#define PRESS_HAT(hat)  MACRO_OP(MOP_HAT), (uint8_t)(hat)
+#define STICK(stick, x, y) MACRO_OP(MOP_STICK), (uint8_t)(stick), (uint8_t)(x), (uint8_t)(y)
+#define RELEASE         MACRO_OP(MOP_RELEASE)
+#define COUNT(id)       MACRO_OP(MOP_COUNT), (uint8_t)(id)
+// Host paced waits. These end early once the host does what we're waiting for, but only in
+// builds with HOST_PACING defined. Otherwise they behave like WAIT_MS() for the full timeout.
+#define WAIT_SETTLE(timeout_ms) MACRO_OP(MOP_WAIT_SETTLE), (uint8_t)MACRO_TICKS(timeout_ms), (uint8_t)(MACRO_TICKS(timeout_ms) >> 8)
+#define WAIT_CHANGE(timeout_ms) MACRO_OP(MOP_WAIT_CHANGE), (uint8_t)MACRO_TICKS(timeout_ms), (uint8_t)(MACRO_TICKS(timeout_ms) >> 8)
+#define WAIT_OUT(timeout_ms)    MACRO_OP(MOP_WAIT_OUT), (uint8_t)MACRO_TICKS(timeout_ms), (uint8_t)(MACRO_TICKS(timeout_ms) >> 8)
+
+// Interpreter state for one running program.
+typedef struct {
+	const uint8_t* Program;  // Bytecode, in flash or EEPROM
+	uint8_t    Source;       // Which of the two, a MacroSource_t
+	uint16_t   PC;           // Offset of the next instruction to fetch
+	uint16_t   StepPC;       // Offset of the timed instruction currently running
+	Clock_ms_t StepStarted;  // When the current timed instruction began
+	uint16_t   StepDuration; // How long it lasts, in ms
+	uint8_t    StepInput;    // Input it holds, on top of the held buttons
+	uint8_t    StepWait;     // Host event that ends it early, or MACRO_NO_WAIT
+	uint8_t    StepSnapshot; // What the host event is compared against
+	uint16_t   HeldButtons;  // Buttons held by MOP_PRESS
+	uint8_t    HeldHAT;      // HAT held by MOP_HAT
+	struct {
+		uint8_t X;
+		uint8_t Y;
+	} HeldSticks[2];         // Sticks held by MOP_STICK, by MACRO_STICK_LEFT and MACRO_STICK_RIGHT
+	uint8_t    Depth;        // Number of open REPEAT blocks
+	struct {
+		uint16_t Start;
+		uint8_t  Count;
+	} Loops[MACRO_MAX_DEPTH];
+#ifdef SERIAL_STREAM
+	uint16_t   FetchedPC;    // PC of the streamed instruction in Fetched
+	uint8_t    Fetched[MACRO_MAX_INSTRUCTION];
+	bool       Stalled;      // The host stopped sending before the stream reached END
+#endif
+} Macro_t;
+
+// Variables
+extern MacroTiming_t MacroTiming;
+
+// Function Prototypes
+// Start running a program from its first instruction.
+void Macro_Start(Macro_t* const Macro, const MacroSource_t Source, const uint8_t* const Program, const Clock_ms_t Now);
+// Run a program straight after the one that just ended, or the same one again. Unlike Macro_Start(), the step
+// that was last held is remembered, so a pipelined release gap is still inserted if it starts the way the last one ended.
+void Macro_Chain(Macro_t* const Macro, const MacroSource_t Source, const uint8_t* const Program);
+// Advance the program to the given time and write the report it holds then.
+// Returns false once the program has reached its end, with nothing pressed in the report.
+bool Macro_Run(Macro_t* const Macro, USB_JoystickReport_Input_t* const ReportData, const Clock_ms_t Now);
+
+#endif
@@ -0,0 +1,138 @@
+/** \file
+ *
+ *  Macro programs replayed by the firmware.
+ *
+ *  Generated by Tools/macroc from Macros.mac, edit that file instead.
+ */
+
+#include "Macros.h"
+
+// Picks the highlighted deck, confirms it, then answers the opening hand prompt once the match has loaded.
+const uint8_t deck_select[] PROGMEM = {
+	REPEAT(2),
+		TAP(NOTHING,  48),
+		HOLD(A,      144),
+	LOOP,
+	WAIT_CHANGE(960),
+	WAIT_SETTLE(2040),
+	TAP(NOTHING,  48),
+	HOLD(A,      144),
+	END
+};
+
+// Passes one turn: B backs out of any card, DOWN DOWN moves to Pass, A picks it and A discards the card.
+// The turn then has to resolve before the next one can be passed: the rival plays its card and both are
+// revealed, about 8 s in all going by the 1:58 a match takes on the console. The reveal is where the
+// console's polls falter, so wait_change gets most of it and wait_settle the rest; if they never falter,
+// the turn still gets its full time.
+const uint8_t pass_turn[] PROGMEM = {
+	TAP(NOTHING,  48),
+	HOLD(B,      144),
+	REPEAT(2),
+		TAP(NOTHING,  48),
+		HOLD(DOWN,   144),
+	LOOP,
+	REPEAT(2),
+		TAP(NOTHING,  48),
+		HOLD(A,      144),
+	LOOP,
+	WAIT_CHANGE(7104),
+	WAIT_SETTLE(936),
+	COUNT(COUNTER_TURNS),
+	END
+};
+
+// Passes every turn after a match's first one, in builds with QUICK_PASS. The turn before left the cursor
+// on Pass, so A picks it straight away and A discards the card, then waits for the turn like pass_turn[].
+const uint8_t pass_again[] PROGMEM = {
+	REPEAT(2),
+		TAP(NOTHING,  48),
+		HOLD(A,      144),
+	LOOP,
+	WAIT_CHANGE(7104),
+	WAIT_SETTLE(936),
+	COUNT(COUNTER_TURNS),
+	END
+};
+
+// Waits for the final score to be counted, then skips the results screens.
+const uint8_t results[] PROGMEM = {
+	WAIT_CHANGE(960),
+	WAIT_SETTLE(1540),
+	REPEAT(2),
+		TAP(NOTHING,  48),
+		HOLD(A,      144),
+	LOOP,
+	END
+};
+
+// Dismisses the level up and reward popups that follow the results, once the first one has rumbled the controller.
+const uint8_t popups[] PROGMEM = {
+	WAIT_OUT(1000),
+	REPEAT(2),
+		TAP(NOTHING,  48),
+		HOLD(A,      144),
+	LOOP,
+	END
+};
+
+// Accepts the rematch and waits for the deck select screen.
+const uint8_t rematch[] PROGMEM = {
+	TAP(NOTHING,  48),
+	HOLD(A,      144),
+	WAIT_CHANGE(480),
+	WAIT_SETTLE(1020),
+	END
+};
+
+// Declines the rematch, in builds with RIVAL_ROTATION, to play another rival of the dojo next. The
+// cursor is on the rival just played once the list is back.
+const uint8_t rival_leave[] PROGMEM = {
+	TAP(NOTHING,  48),
+	HOLD(DOWN,   144),
+	TAP(NOTHING,  48),
+	HOLD(A,      144),
+	WAIT_CHANGE(960),
+	WAIT_SETTLE(1540),
+	END
+};
+
+// Moves the cursor up or down the rival list by one rival, played once for every rival passed.
+const uint8_t rival_up[] PROGMEM = {
+	TAP(NOTHING,  48),
+	HOLD(UP,     144),
+	END
+};
+
+const uint8_t rival_down[] PROGMEM = {
+	TAP(NOTHING,  48),
+	HOLD(DOWN,   144),
+	END
+};
+
+// Challenges the highlighted rival, skips its greeting and waits for the deck select screen.
+const uint8_t rival_pick[] PROGMEM = {
+	TAP(NOTHING,  48),
+	HOLD(A,      144),
+	WAIT_CHANGE(480),
+	WAIT_SETTLE(1020),
+	REPEAT(2),
+		TAP(NOTHING,  48),
+		HOLD(A,      144),
+	LOOP,
+	WAIT_CHANGE(480),
+	WAIT_SETTLE(1020),
+	END
+};
+
+// Gets back to a known screen after the pass loop has drifted into the wrong menu, e.g. because the
+// console dropped an input. B backs out of every menu and popup the loop can end up in, and the
+// wait gives the deck select screen time to come back before the next match starts.
+const uint8_t recover[] PROGMEM = {
+	REPEAT(6),
+		TAP(NOTHING,  48),
+		HOLD(B,      144),
+	LOOP,
+	WAIT_MS(1500),
+	END
+};
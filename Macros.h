@@ -0,0 +1,27 @@
+/** \file
+ *
+ *  Header file for the macro programs in Macros.c.
+ *
+ *  Generated by Tools/macroc from Macros.mac, edit that file instead.
+ */
+
+#ifndef _MACROS_H_
+#define _MACROS_H_
+
+/* Includes: */
+#include "Macro.h"
+
+// Macro programs
+extern const uint8_t deck_select[] PROGMEM;
+extern const uint8_t pass_turn[] PROGMEM;
+extern const uint8_t pass_again[] PROGMEM;
+extern const uint8_t results[] PROGMEM;
+extern const uint8_t popups[] PROGMEM;
+extern const uint8_t rematch[] PROGMEM;
+extern const uint8_t rival_leave[] PROGMEM;
+extern const uint8_t rival_up[] PROGMEM;
+extern const uint8_t rival_down[] PROGMEM;
+extern const uint8_t rival_pick[] PROGMEM;
+extern const uint8_t recover[] PROGMEM;
+
+#endif
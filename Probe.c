@@ -0,0 +1,107 @@
+/** \file
+ *
+ *  Cycle counts of the firmware's hot path, built in with CYCLE_PROFILE (make profile).
+ *  Each probe tracks the shortest, longest and average time its code took, read with the
+ *  Timer1 counts behind the millisecond clock, and drives a pin for a logic analyzer.
+ */
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#include "Probe.h"
+#include "Timing.h"
+
+#ifdef CYCLE_PROFILE
+
+Probes_t Probes;
+
+// Set while the IN endpoint is free without a report to put in it, so a stretch of polls only counts as one miss.
+static bool       Missing;
+// When the IN endpoint was last seen holding a report the host hadn't taken yet.
+static Clock_ms_t LastBusy;
+
+void Probe_Init(void)
+{
+	// PORTD pins 0 to PROBE_COUNT - 1 follow the probes, PORTB pin 0 toggles on every missed or late poll.
+	DDRD  |= (1 << PROBE_COUNT) - 1;
+	PORTD &= ~((1 << PROBE_COUNT) - 1);
+	DDRB  |= (1 << 0);
+	PORTB &= ~(1 << 0);
+
+	Probe_Reset();
+}
+
+void Probe_Reset(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (uint8_t Id = 0; Id < PROBE_COUNT; Id++)
+		{
+			Probes.Probes[Id].Min   = UINT16_MAX;
+			Probes.Probes[Id].Max   = 0;
+			Probes.Probes[Id].Total = 0;
+			Probes.Probes[Id].Runs  = 0;
+		}
+
+		Probes.Version        = PROBES_VERSION;
+		Probes.CyclesPerCount = CLOCK_PRESCALER;
+		Probes.CPUMHz         = F_CPU / 1000000UL;
+		Probes.MissedPolls    = 0;
+		Probes.LatePolls      = 0;
+	}
+}
+
+void Probe_Enter(const ProbeId_t Id)
+{
+	PORTD |= (1 << Id);
+}
+
+void Probe_Leave(const ProbeId_t Id, const uint16_t Started)
+{
+	uint16_t      Counts = Clock_Counts() - Started;
+	ProbeStats_t* Stats  = &Probes.Probes[Id];
+
+	PORTD &= ~(1 << Id);
+
+	// HID_Task() can run from an interrupt, in the middle of another probe's update.
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (Counts < Stats->Min)
+			Stats->Min = Counts;
+		if (Counts > Stats->Max)
+			Stats->Max = Counts;
+		Stats->Total += Counts;
+		Stats->Runs++;
+	}
+}
+
+void Probe_Poll(const bool INReady, const bool HaveReport, const Clock_ms_t Now)
+{
+	if (!INReady)
+	{
+		LastBusy = Now;
+		Missing  = false;
+		return;
+	}
+
+	if (!HaveReport && !Missing)
+	{
+		Probes.MissedPolls++;
+		PINB = (1 << 0);
+	}
+
+	Missing = !HaveReport;
+}
+
+void Probe_RecordIN(const Clock_ms_t Now)
+{
+	// The host polls again a poll interval after taking our last report, so filling the endpoint any
+	// later than that means it found the endpoint empty at least once.
+	if ((Clock_ms_t)(Now - LastBusy) > POLLING_MS)
+	{
+		Probes.LatePolls++;
+		PINB = (1 << 0);
+	}
+}
+
+#endif
@@ -0,0 +1,73 @@
+/** \file
+ *
+ *  Header file for Probe.c.
+ */
+
+#ifndef _PROBE_H_
+#define _PROBE_H_
+
+/* Includes: */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Clock.h"
+
+// Macros
+// Layout version of Probes_t, bumped whenever a field is added or moved.
+#define PROBES_VERSION 1
+
+// Wrap a stretch of code in these to time it. They compile to nothing unless CYCLE_PROFILE is defined.
+#ifdef CYCLE_PROFILE
+	#define PROBE_BEGIN(id) const uint16_t Probe_Started_##id = Clock_Counts(); Probe_Enter(id)
+	#define PROBE_END(id)   Probe_Leave(id, Probe_Started_##id)
+#else
+	#define PROBE_BEGIN(id)
+	#define PROBE_END(id)
+#endif
+
+// Type Defines
+// Code timed by the profiling build. While one runs, the PORTD pin of the same number is high.
+typedef enum {
+	PROBE_HID_TASK,    // HID_Task(), answering IN and OUT polls
+	PROBE_NEXT_REPORT, // GetNextReport(), building one report
+	PROBE_MACRO_RUN,   // Macro_Run(), the interpreter's share of that
+	PROBE_USB_TASK,    // USB_USBTask(), LUFA's control request handling
+	PROBE_COUNT
+} ProbeId_t;
+
+// Timings of one probe, in timer counts of CyclesPerCount CPU cycles each.
+typedef struct {
+	uint16_t Min;
+	uint16_t Max;
+	uint32_t Total; // Sum of every run, for the average
+	uint32_t Runs;
+} ProbeStats_t;
+
+// What the profiling build has measured, read out by a PC with the VENDOR_REQ_GetProbes control request.
+// The layout is little endian and packed as declared, see Tools/splatctl.py.
+typedef struct {
+	uint8_t      Version;        // PROBES_VERSION
+	uint8_t      CyclesPerCount; // CLOCK_PRESCALER
+	uint8_t      CPUMHz;         // F_CPU, in MHz
+	uint8_t      Reserved;       // 0, keeps the fields below aligned so hosts see the same layout
+	ProbeStats_t Probes[PROBE_COUNT];
+	uint16_t     MissedPolls;    // IN polls we had no new report ready for, and repeated the last one
+	uint16_t     LatePolls;      // IN reports sent more than a poll interval after the host took the previous one
+} Probes_t;
+
+// Variables
+extern Probes_t Probes;
+
+// Function Prototypes
+// Set up the logic analyzer pins and clear the timings.
+void Probe_Init(void);
+void Probe_Reset(void);
+// Used by PROBE_BEGIN() and PROBE_END().
+void Probe_Enter(const ProbeId_t Id);
+void Probe_Leave(const ProbeId_t Id, const uint16_t Started);
+// Note whether the IN endpoint is free and we have a report due for it, rather than the last one again,
+// on every run of HID_Task(), and when we fill it.
+void Probe_Poll(const bool INReady, const bool HaveReport, const Clock_ms_t Now);
+void Probe_RecordIN(const Clock_ms_t Now);
+
+#endif
@@ -0,0 +1,131 @@
+/** \file
+ *
+ *  Macro profile stored in EEPROM, so a PC can swap in new macro programs and timing
+ *  over USB (see Tools/splatctl.py) instead of reflashing every unit.
+ */
+
+#include "Profile.h"
+
+ProfileStatus_t Profile_Status = PROFILE_NONE;
+
+// Where each program starts in the profile's bytecode, once it is loaded.
+static uint16_t Programs[PROFILE_PROGRAMS];
+
+// Adds up the bytes of the given header and of the bytecode following it in EEPROM.
+static uint8_t Profile_Sum(const Profile_Header_t* const Header)
+{
+	uint8_t Sum = 0;
+
+	for (uint8_t Byte = 0; Byte < sizeof(Profile_Header_t); Byte++)
+		Sum += ((const uint8_t*)Header)[Byte];
+	for (uint16_t Byte = 0; Byte < Header->Length; Byte++)
+		Sum += eeprom_read_byte(PROFILE_CODE + Byte);
+
+	return Sum;
+}
+
+// Works out whether the profile with the given header can be used.
+static ProfileStatus_t Profile_Check(const Profile_Header_t* const Header)
+{
+	if (Header->Magic != PROFILE_MAGIC)
+		return PROFILE_NONE;
+	if (Header->Version != PROFILE_VERSION)
+		return PROFILE_BAD_VERSION;
+	if (Header->TickMS != MACRO_TICK_MS)
+		return PROFILE_BAD_TICK;
+	if (!Header->Length || Header->Length > PROFILE_CODE_SIZE)
+		return PROFILE_BAD_LENGTH;
+	if (!Header->PressScale || !Header->ReleaseScale)
+		return PROFILE_BAD_SCALE;
+
+	for (uint8_t Slot = 0; Slot < PROFILE_PROGRAMS; Slot++)
+	{
+		if (Header->Programs[Slot] != PROFILE_BUILT_IN && Header->Programs[Slot] >= Header->Length)
+			return PROFILE_BAD_LENGTH;
+	}
+
+	// The bytecode has to end with an END, so that no program runs off the end of the profile.
+	if (eeprom_read_byte(PROFILE_CODE + Header->Length - 1) != MACRO_OP(MOP_END))
+		return PROFILE_BAD_LENGTH;
+
+	return Profile_Sum(Header) ? PROFILE_BAD_CHECKSUM : PROFILE_LOADED;
+}
+
+ProfileStatus_t Profile_Load(void)
+{
+	Profile_Header_t Header;
+
+	Profile_Unload();
+
+	eeprom_read_block(&Header, PROFILE_ADDRESS, sizeof(Header));
+	Profile_Status = Profile_Check(&Header);
+
+	if (Profile_Status == PROFILE_LOADED)
+	{
+		memcpy(Programs, Header.Programs, sizeof(Programs));
+		MacroTiming.PressScale   = Header.PressScale;
+		MacroTiming.ReleaseScale = Header.ReleaseScale;
+	}
+
+	return Profile_Status;
+}
+
+void Profile_Unload(void)
+{
+	Profile_Status = PROFILE_NONE;
+	MacroTiming.PressScale   = 100;
+	MacroTiming.ReleaseScale = 100;
+}
+
+bool Profile_Program(const uint8_t Slot, const uint8_t** const Program)
+{
+	if (Profile_Status != PROFILE_LOADED || Programs[Slot] == PROFILE_BUILT_IN)
+		return false;
+
+	*Program = PROFILE_CODE + Programs[Slot];
+	return true;
+}
+
+bool Profile_SaveScales(const uint8_t PressScale, const uint8_t ReleaseScale)
+{
+	Profile_Header_t Header;
+
+	eeprom_read_block(&Header, PROFILE_ADDRESS, sizeof(Header));
+
+	// A profile made for another version or timing profile is good, just not for this build, so we leave it be
+	// rather than throw away its programs.
+	if (Profile_Status == PROFILE_BAD_VERSION || Profile_Status == PROFILE_BAD_TICK)
+		return false;
+
+	// Without a good profile, we write one that holds nothing but the scales and leaves every program to the
+	// built-in one. Its lone END is what a profile's bytecode has to end with.
+	if (Profile_Status != PROFILE_LOADED)
+	{
+		memset(&Header, 0, sizeof(Header));
+		Header.Magic   = PROFILE_MAGIC;
+		Header.Version = PROFILE_VERSION;
+		Header.Length  = 1;
+		Header.TickMS  = MACRO_TICK_MS;
+		for (uint8_t Slot = 0; Slot < PROFILE_PROGRAMS; Slot++)
+			Header.Programs[Slot] = PROFILE_BUILT_IN;
+		eeprom_update_byte((uint8_t*)PROFILE_CODE, MACRO_OP(MOP_END));
+	}
+
+	Header.PressScale   = PressScale;
+	Header.ReleaseScale = ReleaseScale;
+	Header.Checksum     = 0;
+	Header.Checksum     = -Profile_Sum(&Header);
+	eeprom_update_block(&Header, (void*)PROFILE_ADDRESS, sizeof(Header));
+
+	return Profile_Load() == PROFILE_LOADED;
+}
+
+bool Profile_Write(const uint16_t Offset, const uint8_t* const Data, const uint8_t Length)
+{
+	if (Offset >= PROFILE_END || Length > PROFILE_END - Offset)
+		return false;
+
+	// Bytes that already hold the right value aren't written again, which spares the EEPROM.
+	eeprom_update_block(Data, (void*)(PROFILE_ADDRESS + Offset), Length);
+	return true;
+}
@@ -0,0 +1,94 @@
+/** \file
+ *
+ *  Header file for Profile.c.
+ */
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+/* Includes: */
+#include <avr/eeprom.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Macro.h"
+#include "Trace.h"
+
+// Macros
+// First two bytes of a profile ("ST", little endian).
+#define PROFILE_MAGIC      0x5453
+// Layout version of the profile, bumped whenever the format changes.
+#define PROFILE_VERSION    5
+
+// Programs a profile can replace: one per Phase_t, then recover[], pass_again[] and the ones that go to another rival.
+#define PROFILE_RECOVER     PHASE_COUNT
+#define PROFILE_PASS_AGAIN  (PHASE_COUNT + 1)
+#define PROFILE_RIVAL_LEAVE (PHASE_COUNT + 2)
+#define PROFILE_RIVAL_UP    (PHASE_COUNT + 3)
+#define PROFILE_RIVAL_DOWN  (PHASE_COUNT + 4)
+#define PROFILE_RIVAL_PICK  (PHASE_COUNT + 5)
+#define PROFILE_PROGRAMS    (PHASE_COUNT + 6)
+// Names of those programs in Macros.mac, in the same order, for Tools/macroc.
+#define PROFILE_PROGRAM_NAMES { "deck_select", "pass_turn", "results", "popups", "rematch", "recover", "pass_again", \
+                                "rival_leave", "rival_up", "rival_down", "rival_pick" }
+// Program offset of a program the profile leaves to the built-in one.
+#define PROFILE_BUILT_IN   0xFFFF
+
+// The profile starts at the beginning of EEPROM, and its bytecode follows the header. It takes the rest
+// of the EEPROM, up to the saved event trace in builds that have one.
+#define PROFILE_ADDRESS    ((const uint8_t*)0)
+#define PROFILE_CODE       (PROFILE_ADDRESS + sizeof(Profile_Header_t))
+#ifdef EVENT_TRACE
+	#define PROFILE_END    ((uint16_t)(TRACE_EEPROM_ADDRESS - PROFILE_ADDRESS))
+#else
+	#define PROFILE_END    (E2END + 1)
+#endif
+#define PROFILE_CODE_SIZE  (PROFILE_END - sizeof(Profile_Header_t))
+
+// Largest piece of a profile written by one VENDOR_REQ_WriteProfile request.
+#define PROFILE_CHUNK_SIZE 32
+
+// Type Defines
+// Header of a profile in EEPROM. The layout is little endian and packed as declared, see Tools/splatctl.py.
+typedef struct {
+	uint16_t Magic;        // PROFILE_MAGIC
+	uint8_t  Version;      // PROFILE_VERSION
+	uint8_t  Checksum;     // Makes all bytes of the header and the bytecode add up to 0
+	uint16_t Length;       // Bytes of bytecode following the header
+	uint8_t  TickMS;       // MACRO_TICK_MS the bytecode was compiled for
+	uint8_t  PressScale;   // Percentage applied to the hold time of input steps
+	uint8_t  ReleaseScale; // Percentage applied to the hold time of NOTHING steps
+	uint8_t  Reserved;     // 0, keeps Programs aligned so hosts see the same layout
+	uint16_t Programs[PROFILE_PROGRAMS]; // Offset of each program into the bytecode, or PROFILE_BUILT_IN
+} Profile_Header_t;
+
+// Outcome of loading the profile, answered to VENDOR_REQ_LoadProfile.
+typedef enum {
+	PROFILE_NONE,         // There is no profile, the built-in programs run
+	PROFILE_LOADED,       // The profile is in use
+	PROFILE_BAD_VERSION,  // It was written for another firmware version
+	PROFILE_BAD_TICK,     // It was compiled for another timing profile
+	PROFILE_BAD_LENGTH,   // It doesn't fit, or a program lies outside it
+	PROFILE_BAD_SCALE,    // A scale is 0
+	PROFILE_BAD_CHECKSUM, // It is damaged or only partly written
+} ProfileStatus_t;
+
+// Variables
+extern ProfileStatus_t Profile_Status;
+
+// Function Prototypes
+// Check the profile in EEPROM and start using it if it is good. Until then the built-in programs run.
+ProfileStatus_t Profile_Load(void);
+// Stop using the profile, e.g. before it is rewritten.
+void Profile_Unload(void);
+// Looks up a program (a Phase_t or PROFILE_RECOVER) in the profile. Returns false if the built-in one should run.
+bool Profile_Program(const uint8_t Slot, const uint8_t** const Program);
+// Save scales in the profile, in place of its own, and start using them. Without a good profile, one is
+// written that only holds the scales, but one for another version or tick is kept. Returns false if the
+// scales weren't saved, or the profile can't be loaded afterwards.
+bool Profile_SaveScales(const uint8_t PressScale, const uint8_t ReleaseScale);
+// Write part of a profile to EEPROM. Returns false if it doesn't fit.
+bool Profile_Write(const uint16_t Offset, const uint8_t* const Data, const uint8_t Length);
+
+#endif
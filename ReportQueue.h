@@ -0,0 +1,99 @@
+/** \file
+ *
+ *  Small ring of ready-to-send IN reports.
+ *
+ *  The main loop builds reports ahead of time into the free slots, so servicing an IN
+ *  poll only has to copy out the current slot. Each slot is sent a fixed number of
+ *  times (the report plus its echoes) before we move on to the next one. If nothing
+ *  new has been queued by then, the last report keeps being repeated.
+ */
+
+#ifndef _REPORT_QUEUE_H_
+#define _REPORT_QUEUE_H_
+
+/* Includes: */
+#include <stdbool.h>
+#include <stdint.h>
+#include <util/atomic.h>
+
+#include "Report.h"
+
+// Macros
+// Number of slots, including the one being sent. Must be a power of two.
+#define REPORT_QUEUE_SIZE 2
+
+// Type Defines
+typedef struct {
+	USB_JoystickReport_Input_t Report;
+	uint8_t                    Sends; // How many more times this report goes out
+} ReportSlot_t;
+
+typedef struct {
+	ReportSlot_t     Slots[REPORT_QUEUE_SIZE];
+	uint8_t          Head;    // Next slot to fill
+	uint8_t          Tail;    // Slot being sent
+	volatile uint8_t Pending; // Filled slots, including the one being sent
+} ReportQueue_t;
+
+// Inline Functions
+static inline void ReportQueue_Init(ReportQueue_t* const Queue)
+{
+	Queue->Head    = 0;
+	Queue->Tail    = 0;
+	Queue->Pending = 0;
+}
+
+static inline bool ReportQueue_IsFull(const ReportQueue_t* const Queue)
+{
+	return Queue->Pending >= REPORT_QUEUE_SIZE;
+}
+
+static inline bool ReportQueue_IsEmpty(const ReportQueue_t* const Queue)
+{
+	return Queue->Pending == 0;
+}
+
+// Returns true if the next IN poll would get nothing new: the queue is empty, or all it holds is the report
+// being sent, which has already gone out as often as it should and is only repeated until the next one is built.
+static inline bool ReportQueue_IsStarved(const ReportQueue_t* const Queue)
+{
+	return Queue->Pending == 0 || (Queue->Pending == 1 && Queue->Slots[Queue->Tail].Sends == 0);
+}
+
+// Returns the slot to build the next report into. Only valid while the queue isn't full.
+static inline USB_JoystickReport_Input_t* ReportQueue_Reserve(ReportQueue_t* const Queue)
+{
+	return &Queue->Slots[Queue->Head].Report;
+}
+
+// Queues the reserved slot, to be sent the given number of times.
+static inline void ReportQueue_Commit(ReportQueue_t* const Queue, const uint8_t Sends)
+{
+	Queue->Slots[Queue->Head].Sends = Sends;
+	Queue->Head = (Queue->Head + 1) & (REPORT_QUEUE_SIZE - 1);
+
+	// The IN endpoint may be serviced from an interrupt, which also updates the pending count.
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Queue->Pending++;
+	}
+}
+
+// Returns the report to send for this IN poll. Only valid while the queue isn't empty.
+static inline const USB_JoystickReport_Input_t* ReportQueue_Next(ReportQueue_t* const Queue)
+{
+	// Once the current report has gone out enough times, we move on if there's a newer one.
+	if (Queue->Slots[Queue->Tail].Sends == 0 && Queue->Pending > 1)
+	{
+		Queue->Tail = (Queue->Tail + 1) & (REPORT_QUEUE_SIZE - 1);
+		Queue->Pending--;
+	}
+
+	ReportSlot_t* Slot = &Queue->Slots[Queue->Tail];
+	if (Slot->Sends)
+		Slot->Sends--;
+
+	return &Slot->Report;
+}
+
+#endif
@@ -0,0 +1,181 @@
+/** \file
+ *
+ *  Rival rotation, built in with RIVAL_ROTATION (make with-rival-rotation). Every lost match
+ *  earns the same EXP, so the rival that costs the least time per match, recoveries
+ *  included, is the one that earns EXP the fastest. Each rival of the rotation gets a
+ *  short trial, cut short for one that is clearly slower than the fastest so far, then
+ *  the pad settles on the fastest and checks one of the others again now and then.
+ *
+ *  Rivals are changed at the rematch prompt: instead of rematch[], the pad declines, moves
+ *  the cursor up or down the dojo's rival list and challenges the next one.
+ */
+
+#include "Rival.h"
+
+#ifdef RIVAL_ROTATION
+
+// Returns true if rival A takes over Percent % longer per match than rival B.
+static bool Rival_Slower(const Rival_t* const Rival, const uint8_t A, const uint8_t B, const uint8_t Percent)
+{
+	return (uint32_t)Rival->Seconds[A] * Rival->Matches[B] * 100 >
+	       (uint32_t)Rival->Seconds[B] * Rival->Matches[A] * (100 + Percent);
+}
+
+// Returns the fastest rival of those tried, keeping to the current one on a tie, or RIVALS if none has been.
+static uint8_t Rival_Fastest(const Rival_t* const Rival)
+{
+	uint8_t Fastest = RIVALS;
+
+	for (uint8_t Offset = 0; Offset < RIVALS; Offset++)
+	{
+		const uint8_t Next = (Rival->Current + Offset) % RIVALS;
+
+		if (!(Rival->Tried & (1 << Next)) || !Rival->Matches[Next])
+			continue;
+		if (Fastest == RIVALS || Rival_Slower(Rival, Fastest, Next, 0))
+			Fastest = Next;
+	}
+
+	return Fastest;
+}
+
+// Returns the rival the next match is played against.
+static uint8_t Rival_Choose(Rival_t* const Rival)
+{
+	const uint8_t Current = Rival->Current;
+	uint8_t       Fastest = Rival_Fastest(Rival);
+
+	// A trial carries on until it's complete, or the rival turns out to be much slower than the fastest one.
+	if (!(Rival->Tried & (1 << Current)))
+	{
+		if (Rival->Matches[Current] < RIVAL_TRIAL &&
+		    (Fastest == RIVALS || !Rival_Slower(Rival, Current, Fastest, RIVAL_GIVE_UP)))
+			return Current;
+
+		Rival->Tried |= (1 << Current);
+		Fastest = Rival_Fastest(Rival);
+	}
+
+	// The rivals that haven't had their trial go next, down the list.
+	for (uint8_t Offset = 1; Offset < RIVALS; Offset++)
+	{
+		const uint8_t Next = (Current + Offset) % RIVALS;
+
+		if (!(Rival->Tried & (1 << Next)))
+			return Next;
+	}
+
+	// Once every rival is tried, a check that didn't beat the fastest goes back to it.
+	if (Current != Fastest)
+		return Fastest;
+
+#if RIVAL_REVISIT && RIVALS > 1
+	if (++Rival->SinceRevisit >= RIVAL_REVISIT)
+	{
+		Rival->SinceRevisit = 0;
+		if (Rival->Revisit == Fastest)
+			Rival->Revisit = (Rival->Revisit + 1) % RIVALS;
+
+		const uint8_t Check = Rival->Revisit;
+		Rival->Revisit = (Rival->Revisit + 1) % RIVALS;
+		return Check;
+	}
+#endif
+
+	return Fastest;
+}
+
+void Rival_Init(Rival_t* const Rival)
+{
+	*Rival = (Rival_t){
+		.Step    = RIVAL_STAY,
+		.Revisit = 1 % RIVALS,
+	};
+}
+
+void Rival_MatchPlayed(Rival_t* const Rival, const uint32_t Now)
+{
+	const uint8_t  Current = Rival->Current;
+	const uint32_t Taken   = Now - Rival->Started;
+
+	// The first match against a rival follows the way there rather than a rematch, so it isn't timed. The next
+	// rival is only picked once one of its matches is.
+	Rival->Started = Now;
+	if (!Rival->Timed)
+	{
+		Rival->Timed = true;
+		return;
+	}
+
+	if (Taken <= RIVAL_LONGEST_S)
+	{
+		Rival->Seconds[Current] += Taken;
+		if (++Rival->Matches[Current] >= RIVAL_WINDOW)
+		{
+			Rival->Seconds[Current] /= 2;
+			Rival->Matches[Current] /= 2;
+		}
+	}
+
+	Rival->Target = Rival_Choose(Rival);
+	if (Rival->Target == Current)
+		return;
+
+	Rival->Step  = RIVAL_LEAVE;
+	Rival->Moves = (Rival->Target > Current) ? Rival->Target - Current : Current - Rival->Target;
+	Rival->Timed = false;
+}
+
+uint8_t Rival_Slot(const Rival_t* const Rival)
+{
+	switch (Rival->Step)
+	{
+		case RIVAL_LEAVE:
+			return PROFILE_RIVAL_LEAVE;
+		case RIVAL_MOVE:
+			return (Rival->Target > Rival->Current) ? PROFILE_RIVAL_DOWN : PROFILE_RIVAL_UP;
+		case RIVAL_PICK:
+			return PROFILE_RIVAL_PICK;
+		default:
+			return PHASE_REMATCH;
+	}
+}
+
+bool Rival_Stepped(Rival_t* const Rival)
+{
+	switch (Rival->Step)
+	{
+		case RIVAL_LEAVE:
+			Rival->Step = RIVAL_MOVE;
+			return false;
+		case RIVAL_MOVE:
+			if (--Rival->Moves)
+				return false;
+			Rival->Step = RIVAL_PICK;
+			return false;
+		case RIVAL_PICK:
+			Rival->Current = Rival->Target;
+			Rival->Step    = RIVAL_STAY;
+			return true;
+		default:
+			return true;
+	}
+}
+
+void Rival_Untimed(Rival_t* const Rival)
+{
+	Rival->Timed = false;
+}
+
+void Rival_Recovered(Rival_t* const Rival)
+{
+	// recover[] backs out to the deck select screen, which we take to be the rival we were leaving. A recovery
+	// of its own is time lost to that rival, and stays in its match time.
+	if (Rival->Step != RIVAL_STAY)
+	{
+		Rival->Step  = RIVAL_STAY;
+		Rival->Timed = false;
+	}
+}
+
+#endif
@@ -0,0 +1,77 @@
+/** \file
+ *
+ *  Header file for Rival.c.
+ */
+
+#ifndef _RIVAL_H_
+#define _RIVAL_H_
+
+/* Includes: */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Profile.h"
+
+// Macros
+// Rivals in the rotation: the one the unit was started on, and those listed below it in the dojo. Set with make with-rival-rotation RIVALS=4.
+#ifndef RIVALS
+	#define RIVALS 3
+#endif
+#if RIVALS < 1 || RIVALS > 8
+	#error RIVALS has to be 1 to 8.
+#endif
+// Timed matches each rival gets before we settle on the fastest one.
+#ifndef RIVAL_TRIAL
+	#define RIVAL_TRIAL 3
+#endif
+// A rival whose first timed match is this many % slower than the fastest one tried is given up on straight away.
+#ifndef RIVAL_GIVE_UP
+	#define RIVAL_GIVE_UP 25
+#endif
+// Matches played against the fastest rival before the next other one is checked again for a match, 0 never checks again.
+#ifndef RIVAL_REVISIT
+	#define RIVAL_REVISIT 50
+#endif
+// Once a rival has this many timed matches, its totals are halved, so the latest matches count the most.
+#define RIVAL_WINDOW    16
+// A match taking longer than this, in seconds, had the console asleep or stuck rather than the rival being slow, and isn't counted.
+#define RIVAL_LONGEST_S 900
+
+// Type Defines
+// Where a pad is on its way to another rival, in place of the rematch[] program.
+typedef enum {
+	RIVAL_STAY,  // Not going anywhere, rematch[] plays
+	RIVAL_LEAVE, // rival_leave[] declines the rematch, back to the rival list
+	RIVAL_MOVE,  // rival_up[] or rival_down[] moves the cursor down the list, once per rival
+	RIVAL_PICK,  // rival_pick[] challenges the rival, on to the deck select screen
+} RivalStep_t;
+
+// Rotation of one pad, kept as small as the 16u2's RAM wants it.
+typedef struct {
+	uint32_t Started;          // When the match being timed started, in seconds
+	uint16_t Seconds[RIVALS];  // Time taken by the matches timed against each rival, recoveries included
+	uint8_t  Matches[RIVALS];  // and how many those were
+	uint8_t  Tried;            // Bit per rival that has had its trial
+	uint8_t  Current;          // Rival being played, by place in the rotation
+	uint8_t  Target;           // Rival being gone to
+	uint8_t  Step;             // RivalStep_t
+	uint8_t  Moves;            // Cursor moves left down or up the rival list
+	uint8_t  SinceRevisit;     // Matches against the fastest rival since another one was checked
+	uint8_t  Revisit;          // Rival checked next
+	bool     Timed;            // Started holds the start of a match we time
+} Rival_t;
+
+// Function Prototypes
+// Start out on the rival the unit was started on, with nothing timed yet.
+void Rival_Init(Rival_t* const Rival);
+// Time the match that has just been played, once its EXP is in, and pick the rival of the next one.
+void Rival_MatchPlayed(Rival_t* const Rival, const uint32_t Now);
+// Returns the program slot that plays the rematch phase: PHASE_REMATCH, or the next one on the way to another rival.
+uint8_t Rival_Slot(const Rival_t* const Rival);
+// Move on once that program has ended. Returns true once the next match is about to start.
+bool Rival_Stepped(Rival_t* const Rival);
+// Stop timing after a re-sync, and after a recovery cut a change of rival short.
+void Rival_Untimed(Rival_t* const Rival);
+void Rival_Recovered(Rival_t* const Rival);
+
+#endif
@@ -0,0 +1,105 @@
+/** \file
+ *
+ *  Macro bytecode streamed in over the USART, built in with SERIAL_STREAM (make with-serial-stream).
+ *
+ *  The USART receive interrupt puts every byte into a small FIFO, which the interpreter
+ *  takes whole instructions out of (see Macro_Run()). The host is held back with XON/XOFF
+ *  software flow control, so it can stream programs of any length without overrunning us.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <LUFA/Drivers/Peripheral/Serial.h>
+
+#include "Stream.h"
+
+#ifdef SERIAL_STREAM
+
+static volatile uint8_t    Stream_Bytes[STREAM_FIFO_SIZE];
+static volatile uint8_t    Stream_Head;    // Where the next byte received goes
+static uint8_t             Stream_Tail;    // Next byte to consume
+static volatile uint8_t    Stream_Pending; // Bytes received and not consumed yet
+static volatile bool       Stream_Paused;  // We've sent XOFF and not XON since
+static volatile Clock_ms_t Stream_LastByte;
+
+void Stream_Init(void)
+{
+	Serial_Init(STREAM_BAUD, true);
+	UCSR1B |= (1 << RXCIE1);
+
+	// Whatever the host sent before we were listening is lost, so it may as well go on.
+	Serial_SendByte(STREAM_XON);
+}
+
+ISR(USART1_RX_vect, ISR_BLOCK)
+{
+	uint8_t Byte = UDR1;
+
+	// Once full, bytes are dropped. The host only overruns us if it ignores XOFF.
+	if (Stream_Pending < STREAM_FIFO_SIZE)
+	{
+		Stream_Bytes[Stream_Head] = Byte;
+		Stream_Head = (Stream_Head + 1) & (STREAM_FIFO_SIZE - 1);
+		Stream_Pending++;
+	}
+	Stream_LastByte = Clock_Millis();
+
+	if (!Stream_Paused && STREAM_FIFO_SIZE - Stream_Pending <= STREAM_PAUSE_FREE)
+	{
+		Stream_Paused = true;
+		Serial_SendByte(STREAM_XOFF);
+	}
+}
+
+uint8_t Stream_Count(void)
+{
+	return Stream_Pending;
+}
+
+uint8_t Stream_Peek(const uint8_t Offset)
+{
+	return Stream_Bytes[(Stream_Tail + Offset) & (STREAM_FIFO_SIZE - 1)];
+}
+
+void Stream_Drop(const uint8_t Count)
+{
+	bool Resume = false;
+
+	Stream_Tail = (Stream_Tail + Count) & (STREAM_FIFO_SIZE - 1);
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Stream_Pending -= Count;
+		if (Stream_Paused && Stream_Pending <= STREAM_RESUME_LEVEL)
+		{
+			// The host has had nothing to send while paused, so the stall timer starts over from XON.
+			Stream_Paused   = false;
+			Stream_LastByte = Clock_Millis();
+			Resume          = true;
+		}
+	}
+
+	if (Resume)
+		Serial_SendByte(STREAM_XON);
+}
+
+void Stream_Flush(void)
+{
+	Stream_Drop(Stream_Pending);
+}
+
+bool Stream_Stalled(void)
+{
+	Clock_ms_t Silent;
+
+	// A byte arriving in between must not look like it came after now.
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Silent = Clock_Millis() - Stream_LastByte;
+	}
+
+	return Silent >= STREAM_STALL_MS;
+}
+
+#endif
@@ -0,0 +1,43 @@
+/** \file
+ *
+ *  Header file for Stream.c.
+ */
+
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+/* Includes: */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Clock.h"
+
+// Macros
+// Serial link to the host feeding the stream, 8N1 on the USART pins. On the UNO R3 that's the ATmega328P.
+#define STREAM_BAUD         115200
+// Bytes of bytecode the FIFO holds. Must be a power of two.
+#define STREAM_FIFO_SIZE    64
+// Once no more than STREAM_PAUSE_FREE bytes are free, we send the host XOFF, and XON once the FIFO has
+// drained to STREAM_RESUME_LEVEL bytes. The headroom takes the bytes the host sends before it sees XOFF.
+#define STREAM_PAUSE_FREE   16
+#define STREAM_RESUME_LEVEL 16
+#define STREAM_XON          0x11
+#define STREAM_XOFF         0x13
+// The stream has stalled once the host hasn't sent anything for this long while we wait for an instruction (in ms).
+#define STREAM_STALL_MS     500
+
+// Function Prototypes
+// Set up the USART and start taking bytes from the host.
+void Stream_Init(void);
+// Number of bytes received and not consumed yet.
+uint8_t Stream_Count(void);
+// Returns a byte ahead in the FIFO without consuming it. Only valid below Stream_Count().
+uint8_t Stream_Peek(const uint8_t Offset);
+// Consume bytes from the front of the FIFO, letting the host go on once there is room again.
+void Stream_Drop(const uint8_t Count);
+// Drop whatever is left of a stream that stalled.
+void Stream_Flush(void);
+// Returns true once the host has sent nothing for STREAM_STALL_MS.
+bool Stream_Stalled(void);
+
+#endif
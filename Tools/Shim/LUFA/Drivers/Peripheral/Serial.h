@@ -0,0 +1,9 @@
+// Host stand-in for LUFA's USART driver. The simulator plays the host on the other end of the serial link.
+#ifndef _SHIM_SERIAL_H_
+#define _SHIM_SERIAL_H_
+	#include <stdbool.h>
+	#include <stdint.h>
+
+	void Serial_Init(const uint32_t BaudRate, const bool DoubleSpeed);
+	void Serial_SendByte(const char DataByte);
+#endif
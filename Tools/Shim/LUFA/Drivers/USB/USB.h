@@ -0,0 +1,114 @@
+// Host stand-in for the parts of LUFA's USB driver the firmware uses. The endpoint functions
+// are implemented by the simulator, which plays the part of the host.
+#ifndef _SHIM_USB_H_
+#define _SHIM_USB_H_
+	#include <stdbool.h>
+	#include <stddef.h>
+	#include <stdint.h>
+
+	#define ATTR_WARN_UNUSED_RESULT
+	#define ATTR_NON_NULL_PTR_ARG(...)
+
+	#define ENDPOINT_DIR_IN        0x80
+	#define ENDPOINT_DIR_OUT       0x00
+	#define ENDPOINT_CONTROLEP     0
+	#define EP_TYPE_INTERRUPT      0x03
+
+	#define DEVICE_STATE_Unattached 0
+	#define DEVICE_STATE_Configured 4
+
+	#define REQDIR_HOSTTODEVICE    (0 << 7)
+	#define REQDIR_DEVICETOHOST    (1 << 7)
+	#define REQTYPE_STANDARD       (0 << 5)
+	#define REQTYPE_CLASS          (1 << 5)
+	#define REQTYPE_VENDOR         (2 << 5)
+	#define REQREC_DEVICE          (0 << 0)
+	#define REQREC_INTERFACE       (1 << 0)
+
+	#define MIN(x, y)              (((x) < (y)) ? (x) : (y))
+	#define MAX(x, y)              (((x) > (y)) ? (x) : (y))
+
+	#define GlobalInterruptEnable()
+
+	typedef struct
+	{
+		uint8_t Size;
+		uint8_t Type;
+	} USB_Descriptor_Header_t;
+
+	typedef struct
+	{
+		USB_Descriptor_Header_t Header;
+		uint16_t TotalConfigurationSize;
+		uint8_t  TotalInterfaces;
+		uint8_t  ConfigurationNumber;
+		uint8_t  ConfigurationStrIndex;
+		uint8_t  ConfigAttributes;
+		uint8_t  MaxPowerConsumption;
+	} USB_Descriptor_Configuration_Header_t;
+
+	typedef struct
+	{
+		USB_Descriptor_Header_t Header;
+		uint8_t InterfaceNumber;
+		uint8_t AlternateSetting;
+		uint8_t TotalEndpoints;
+		uint8_t Class;
+		uint8_t SubClass;
+		uint8_t Protocol;
+		uint8_t InterfaceStrIndex;
+	} USB_Descriptor_Interface_t;
+
+	typedef struct
+	{
+		USB_Descriptor_Header_t Header;
+		uint16_t HIDSpec;
+		uint8_t  CountryCode;
+		uint8_t  TotalReportDescriptors;
+		uint8_t  HIDReportType;
+		uint16_t HIDReportLength;
+	} USB_HID_Descriptor_HID_t;
+
+	typedef struct
+	{
+		USB_Descriptor_Header_t Header;
+		uint8_t  EndpointAddress;
+		uint8_t  Attributes;
+		uint16_t EndpointSize;
+		uint8_t  PollingIntervalMS;
+	} USB_Descriptor_Endpoint_t;
+
+	typedef struct
+	{
+		uint8_t  bmRequestType;
+		uint8_t  bRequest;
+		uint16_t wValue;
+		uint16_t wIndex;
+		uint16_t wLength;
+	} USB_Request_Header_t;
+
+	extern volatile uint8_t     USB_DeviceState;
+	extern USB_Request_Header_t USB_ControlRequest;
+
+	void     USB_Init(void);
+	void     USB_USBTask(void);
+	void     USB_Device_EnableSOFEvents(void);
+	void     USB_Device_DisableSOFEvents(void);
+	uint16_t USB_Device_GetFrameNumber(void);
+
+	bool     Endpoint_ConfigureEndpoint(const uint8_t Address, const uint8_t Type, const uint16_t Size, const uint8_t Banks);
+	uint8_t  Endpoint_GetCurrentEndpoint(void);
+	void     Endpoint_SelectEndpoint(const uint8_t Address);
+	bool     Endpoint_IsINReady(void);
+	bool     Endpoint_IsOUTReceived(void);
+	bool     Endpoint_IsReadWriteAllowed(void);
+	void     Endpoint_ClearIN(void);
+	void     Endpoint_ClearOUT(void);
+	uint8_t  Endpoint_Write_Stream_LE(const void* const Buffer, uint16_t Length, uint16_t* const BytesProcessed);
+	uint8_t  Endpoint_Read_Stream_LE(void* const Buffer, uint16_t Length, uint16_t* const BytesProcessed);
+	void     Endpoint_ClearSETUP(void);
+	void     Endpoint_ClearStatusStage(void);
+	void     Endpoint_StallTransaction(void);
+	uint8_t  Endpoint_Write_Control_Stream_LE(const void* const Buffer, uint16_t Length);
+	uint8_t  Endpoint_Read_Control_Stream_LE(void* const Buffer, uint16_t Length);
+#endif
@@ -0,0 +1 @@
+// Host stand-in for LUFA's platform header.
@@ -0,0 +1,17 @@
+// Host stand-in for avr-libc's <avr/eeprom.h>. EEPROM is a plain array here, defined by the tool that
+// links the firmware, and an EEPROM address is an offset into it.
+#ifndef _SHIM_EEPROM_H_
+#define _SHIM_EEPROM_H_
+	#include <stdint.h>
+	#include <string.h>
+
+	// The smallest EEPROM of the supported MCUs, the atmega16u2's.
+	#define E2END 511
+
+	extern uint8_t Shim_EEPROM[E2END + 1];
+
+	#define eeprom_read_byte(addr)              (Shim_EEPROM[(uintptr_t)(addr)])
+	#define eeprom_read_block(dst, src, len)    memcpy((dst), &Shim_EEPROM[(uintptr_t)(src)], (len))
+	#define eeprom_update_byte(addr, value)     (Shim_EEPROM[(uintptr_t)(addr)] = (value))
+	#define eeprom_update_block(src, dst, len)  memcpy(&Shim_EEPROM[(uintptr_t)(dst)], (src), (len))
+#endif
@@ -0,0 +1,7 @@
+// Host stand-in for <avr/interrupt.h>. Interrupt handlers become plain functions the simulator can call.
+#ifndef _SHIM_INTERRUPT_H_
+#define _SHIM_INTERRUPT_H_
+	#define ISR(vector, ...) void vector(void); void vector(void)
+	#define sei()
+	#define cli()
+#endif
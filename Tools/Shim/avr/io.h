@@ -0,0 +1,25 @@
+// Host stand-in for <avr/io.h>. The registers the firmware touches are plain variables, defined by the simulator.
+#ifndef _SHIM_IO_H_
+#define _SHIM_IO_H_
+	#include <stdint.h>
+
+	extern volatile uint8_t  MCUSR;
+	extern volatile uint8_t  DDRB, PORTB, PINB;
+	extern volatile uint8_t  DDRD, PORTD, PIND;
+	extern volatile uint8_t  TCCR1A, TCCR1B, TIMSK1;
+	extern volatile uint16_t OCR1A, TCNT1;
+	extern volatile uint8_t  UCSR1B, UDR1;
+
+	// The atmega16u2's RAM, the smallest of the MCUs the firmware runs on.
+	#define RAMSTART 0x100
+	#define RAMEND   0x2FF
+
+	#define EXTRF  1
+	#define WDRF   3
+	#define WGM12  3
+	#define CS10   0
+	#define CS11   1
+	#define CS12   2
+	#define OCIE1A 1
+	#define RXCIE1 7
+#endif
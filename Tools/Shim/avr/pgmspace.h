@@ -0,0 +1,12 @@
+// Host stand-in for avr-libc's <avr/pgmspace.h>, so the macro tables and the interpreter
+// can be built with the host compiler. Flash is ordinary memory here.
+#ifndef _SHIM_PGMSPACE_H_
+#define _SHIM_PGMSPACE_H_
+	#include <stdint.h>
+	#include <string.h>
+
+	#define PROGMEM
+	#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+	#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+	#define memcpy_P(dst, src, len) memcpy((dst), (src), (len))
+#endif
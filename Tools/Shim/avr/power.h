@@ -0,0 +1,9 @@
+// Host stand-in for <avr/power.h>.
+#ifndef _SHIM_POWER_H_
+#define _SHIM_POWER_H_
+	#define clock_div_1 0
+
+	#define clock_prescale_set(div)
+	#define power_adc_disable()
+	#define power_spi_disable()
+#endif
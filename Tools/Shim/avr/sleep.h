@@ -0,0 +1,8 @@
+// Host stand-in for <avr/sleep.h>. The simulator's clock only moves between calls, so sleeping returns at once.
+#ifndef _SHIM_SLEEP_H_
+#define _SHIM_SLEEP_H_
+	#define SLEEP_MODE_IDLE 0
+
+	#define set_sleep_mode(mode) do { } while (0)
+	#define sleep_mode()         do { } while (0)
+#endif
@@ -0,0 +1,12 @@
+// Host stand-in for <avr/wdt.h>.
+#ifndef _SHIM_WDT_H_
+#define _SHIM_WDT_H_
+	#define WDTO_1S 6
+	#define WDTO_2S 7
+	#define WDTO_4S 8
+	#define WDTO_8S 9
+
+	#define wdt_enable(timeout)
+	#define wdt_disable()
+	#define wdt_reset()
+#endif
@@ -0,0 +1,6 @@
+// Host stand-in for <util/atomic.h>. The simulator is single threaded, so the block just runs once.
+#ifndef _SHIM_ATOMIC_H_
+#define _SHIM_ATOMIC_H_
+	#define ATOMIC_RESTORESTATE 0
+	#define ATOMIC_BLOCK(type)  for (int _AtomicOnce = 1; _AtomicOnce; _AtomicOnce = 0)
+#endif
@@ -0,0 +1,1009 @@
+/*
+ * Macro compiler: turns the macro script (Macros.mac) into Macros.c and Macros.h.
+ *
+ * Every instruction is written out with the bytecode helpers from Macro.h, so the
+ * firmware's compiler folds the programs into packed PROGMEM tables and nothing is
+ * parsed on the device. Each step is sized (one byte TAP or two byte HOLD) so it fits
+ * with every timing profile's tick, see MACRO_TICK_MS_MIN in Config/Timing.h.
+ *
+ * The timing is checked against the profile this tool was built for (POLLING_MS and
+ * ECHOES), and the time each program and a whole match takes is printed. Build it with
+ * the same -D flags as the firmware, as the makefile does.
+ *
+ * With -p, the same programs are also written out as an EEPROM profile (see Profile.h)
+ * for Tools/splatctl.py to write to running units. Its bytecode is encoded for this
+ * build's MACRO_TICK_MS, and the firmware only loads it if that matches its own.
+ *
+ * With -s, one match is written out as plain bytecode, for a host to stream to units
+ * built with SERIAL_STREAM (see Stream.h): the phases of the "match" line in order, with
+ * TURNS runs of the turn phase, as a single program ending on the deck select screen.
+ * Repeat blocks are unrolled, since a stream can't go back, and programs that jump are
+ * refused.
+ *
+ *     macroc [-p Macros.bin] [-s Stream.bin] Macros.mac [Macros.c Macros.h]
+ *
+ * The outputs are only written when the whole script compiled.
+ */
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Macro.h"
+#include "Profile.h"
+
+#define MAX_LINE     256
+#define MAX_TOKENS   8
+#define MAX_PROGRAMS 16
+#define MAX_LABELS   16
+#define MAX_NAME     32
+
+// Longest step that still fits a two byte HOLD with the finest tick of any profile.
+#define STEP_MAX_MS  (0xFF * MACRO_TICK_MS_MIN)
+// Longest step that still fits a one byte TAP with the finest tick of any profile.
+#define TAP_MAX_MS   (0x0F * MACRO_TICK_MS_MIN)
+// Longest wait. The firmware times a step in ms with the 16-bit Clock_ms_t, so a wait has to stay well short of
+// 65536 ms whatever the tick, with room left for the step to be looked at a little late without it wrapping.
+#define WAIT_MAX_MS  60000UL
+
+typedef struct {
+	char          Name[MAX_NAME];
+	unsigned long MS;     // Time one run takes with this profile
+	size_t        Offset; // Where its bytecode starts in the EEPROM profile
+	unsigned      Jumps;  // Line of its first label or jump, 0 if it has none
+} Program_t;
+
+// Output being built up, so nothing is written unless the whole script compiles.
+typedef struct {
+	char*  Data;
+	size_t Length;
+	size_t Size;
+} Buffer_t;
+
+// Inputs in Buttons_t order, as written in the script and in C.
+static const char* const InputNames[] = {
+	"UP", "DOWN", "LEFT", "RIGHT", "A", "B", "NOTHING",
+	"A+UP", "A+DOWN", "A+LEFT", "A+RIGHT", "B+UP", "B+DOWN", "B+LEFT", "B+RIGHT",
+};
+static const char* const InputSymbols[] = {
+	"UP", "DOWN", "LEFT", "RIGHT", "A", "B", "NOTHING",
+	"A_UP", "A_DOWN", "A_LEFT", "A_RIGHT", "B_UP", "B_DOWN", "B_LEFT", "B_RIGHT",
+};
+
+static const struct {
+	const char* Name;
+	const char* Symbol;
+	uint16_t    Mask;
+} ButtonNames[] = {
+	{ "Y", "SWITCH_Y", SWITCH_Y }, { "B", "SWITCH_B", SWITCH_B }, { "A", "SWITCH_A", SWITCH_A }, { "X", "SWITCH_X", SWITCH_X },
+	{ "L", "SWITCH_L", SWITCH_L }, { "R", "SWITCH_R", SWITCH_R }, { "ZL", "SWITCH_ZL", SWITCH_ZL }, { "ZR", "SWITCH_ZR", SWITCH_ZR },
+	{ "MINUS", "SWITCH_MINUS", SWITCH_MINUS }, { "PLUS", "SWITCH_PLUS", SWITCH_PLUS },
+	{ "LCLICK", "SWITCH_LCLICK", SWITCH_LCLICK }, { "RCLICK", "SWITCH_RCLICK", SWITCH_RCLICK },
+	{ "HOME", "SWITCH_HOME", SWITCH_HOME }, { "CAPTURE", "SWITCH_CAPTURE", SWITCH_CAPTURE },
+};
+
+static const char* const HATNames[] = {
+	"TOP", "TOP_RIGHT", "RIGHT", "BOTTOM_RIGHT", "BOTTOM", "BOTTOM_LEFT", "LEFT", "TOP_LEFT", "CENTER",
+};
+
+static const char* Script;
+static unsigned    LineNumber;
+static unsigned    Errors;
+static unsigned    Warnings;
+
+static Buffer_t Source;
+static Buffer_t Header;
+static Buffer_t Code; // Bytecode of every program, for the EEPROM profile
+
+// Scales for the EEPROM profile, in percent.
+static unsigned long PressScale   = 100;
+static unsigned long ReleaseScale = 100;
+
+static Program_t Programs[MAX_PROGRAMS];
+static unsigned  ProgramCount;
+
+static void Append(Buffer_t* const Buffer, const char* const Format, ...)
+{
+	va_list Args;
+
+	for (;;)
+	{
+		size_t Free = Buffer->Size - Buffer->Length;
+		int    Length;
+
+		va_start(Args, Format);
+		Length = vsnprintf(Buffer->Data + Buffer->Length, Free, Format, Args);
+		va_end(Args);
+
+		if (Length >= 0 && (size_t)Length < Free)
+		{
+			Buffer->Length += Length;
+			return;
+		}
+
+		Buffer->Size = Buffer->Size ? Buffer->Size * 2 : 4096;
+		Buffer->Data = realloc(Buffer->Data, Buffer->Size);
+		if (!Buffer->Data)
+		{
+			fprintf(stderr, "macroc: out of memory\n");
+			exit(1);
+		}
+	}
+}
+
+// Appends one byte of binary output, which may well be zero, so this doesn't go through Append().
+static void AppendByte(Buffer_t* const Buffer, const uint8_t Byte)
+{
+	if (Buffer->Length == Buffer->Size)
+	{
+		Buffer->Size = Buffer->Size ? Buffer->Size * 2 : 256;
+		Buffer->Data = realloc(Buffer->Data, Buffer->Size);
+		if (!Buffer->Data)
+		{
+			fprintf(stderr, "macroc: out of memory\n");
+			exit(1);
+		}
+	}
+
+	Buffer->Data[Buffer->Length++] = Byte;
+}
+
+static void Emit(const uint8_t Byte)
+{
+	AppendByte(&Code, Byte);
+}
+
+static void EmitWord(const uint16_t Word)
+{
+	Emit(Word & 0xFF);
+	Emit(Word >> 8);
+}
+
+static void Report(const char* const Kind, const char* const Format, va_list Args)
+{
+	fprintf(stderr, "%s:%u: %s: ", Script, LineNumber, Kind);
+	vfprintf(stderr, Format, Args);
+	fprintf(stderr, "\n");
+}
+
+static void Error(const char* const Format, ...)
+{
+	va_list Args;
+	va_start(Args, Format);
+	Report("error", Format, Args);
+	va_end(Args);
+	Errors++;
+}
+
+static void Warning(const char* const Format, ...)
+{
+	va_list Args;
+	va_start(Args, Format);
+	Report("warning", Format, Args);
+	va_end(Args);
+	Warnings++;
+}
+
+// Returns the index of Name in the table, or -1.
+static int Find(const char* const Name, const char* const* const Table, const unsigned Count)
+{
+	for (unsigned Index = 0; Index < Count; Index++)
+	{
+		if (strcmp(Name, Table[Index]) == 0)
+			return Index;
+	}
+
+	return -1;
+}
+
+// Parses a positive number of milliseconds, with an optional "ms" suffix.
+static bool ParseMS(const char* const Token, unsigned long* const MS)
+{
+	char* End;
+
+	*MS = strtoul(Token, &End, 10);
+	if (End == Token || (*End && strcmp(End, "ms") != 0) || !*MS)
+	{
+		Error("'%s' is not a time in ms", Token);
+		return false;
+	}
+
+	return true;
+}
+
+static bool ParseCount(const char* const Token, unsigned long* const Count)
+{
+	char* End;
+
+	*Count = strtoul(Token, &End, 10);
+	if (!strcmp(Token, "TURNS"))
+		*Count = TURNS;
+	else if (End == Token || *End || !*Count || *Count > UINT8_MAX)
+	{
+		Error("'%s' is not a count from 1 to %u", Token, UINT8_MAX);
+		return false;
+	}
+
+	return true;
+}
+
+static bool IsIdentifier(const char* const Name)
+{
+	if (!*Name || strlen(Name) >= MAX_NAME || !(isalpha((unsigned char)*Name) || *Name == '_'))
+		return false;
+
+	for (const char* Char = Name; *Char; Char++)
+	{
+		if (!isalnum((unsigned char)*Char) && *Char != '_')
+			return false;
+	}
+
+	return true;
+}
+
+// Time a step of the given length is actually held for with this profile, in ms. It lasts a whole number
+// of ticks, and the report it is in stays on the wire for a whole report window.
+static unsigned long HeldMS(const unsigned long MS)
+{
+	unsigned long Ticked = MACRO_TICKS(MS) * MACRO_TICK_MS;
+	return (Ticked + REPORT_WINDOW_MS - 1) / REPORT_WINDOW_MS * REPORT_WINDOW_MS;
+}
+
+static void Indent(const unsigned Depth)
+{
+	for (unsigned Level = 0; Level <= Depth; Level++)
+		Append(&Source, "\t");
+}
+
+// Compiles one program, up to and including its "end" line, and prints how long it takes.
+static void CompileProgram(FILE* const File, Program_t* const Program)
+{
+	char          Labels[MAX_LABELS][MAX_NAME];
+	bool          Defined[MAX_LABELS] = { false };
+	unsigned      LabelLines[MAX_LABELS];
+	unsigned      LabelCount = 0;
+	unsigned long Repeats[MACRO_MAX_DEPTH + 1] = { 1 };
+	unsigned      Depth = 0;
+	unsigned long Rounded = 0;
+	char          Line[MAX_LINE];
+
+	Program->Offset = Code.Length;
+	Append(&Source, "const uint8_t %s[] PROGMEM = {\n", Program->Name);
+	Append(&Header, "extern const uint8_t %s[] PROGMEM;\n", Program->Name);
+
+	while (fgets(Line, sizeof(Line), File))
+	{
+		char*    Tokens[MAX_TOKENS];
+		unsigned Count = 0;
+		char*    Comment;
+
+		LineNumber++;
+
+		// Comments of their own are kept, the others are dropped with the rest of the line.
+		for (Comment = Line; isspace((unsigned char)*Comment); Comment++);
+		if (*Comment == '#')
+		{
+			Comment[strcspn(Comment, "\r\n")] = '\0';
+			Indent(Depth);
+			Append(&Source, "//%s\n", Comment + 1);
+			continue;
+		}
+		Line[strcspn(Line, "#\r\n")] = '\0';
+
+		for (char* Token = strtok(Line, " \t"); Token && Count < MAX_TOKENS; Token = strtok(NULL, " \t"))
+			Tokens[Count++] = Token;
+		if (!Count)
+			continue;
+
+		const char* Command = Tokens[0];
+		unsigned long Value;
+		int Index;
+
+		if (!strcmp(Command, "end"))
+		{
+			if (Depth)
+				Error("repeat without a loop before the end of %s", Program->Name);
+
+			unsigned EndLine = LineNumber;
+			for (unsigned Label = 0; Label < LabelCount; Label++)
+			{
+				if (!Defined[Label])
+				{
+					LineNumber = LabelLines[Label];
+					Error("jump to %s, which has no label in %s", Labels[Label], Program->Name);
+				}
+			}
+			LineNumber = EndLine;
+
+			Append(&Source, "\tEND\n};\n");
+			Emit(MACRO_OP(MOP_END));
+
+			printf("  %-16s %7lu ms", Program->Name, Program->MS);
+			if (Rounded)
+				printf(" (%lu ms of it from rounding up to whole %u ms report windows)", Rounded, REPORT_WINDOW_MS);
+			printf("\n");
+			return;
+		}
+		else if ((Index = Find(Command, InputNames, sizeof(InputNames) / sizeof(InputNames[0]))) >= 0)
+		{
+			if (Count != 2 || !ParseMS(Tokens[1], &Value))
+			{
+				Error("expected '%s <ms>'", Command);
+				continue;
+			}
+			if (Value > STEP_MAX_MS)
+			{
+				Error("%lu ms is too long for one step (up to %u ms), hold the button with press and wait instead", Value, STEP_MAX_MS);
+				continue;
+			}
+			if (Index != NOTHING && Value < REPORT_WINDOW_MS)
+				Warning("%s %lu ms is shorter than a report window, it will be held for %u ms", Command, Value, REPORT_WINDOW_MS);
+
+#ifdef MACRO_PIPELINE
+			// The interpreter drops NOTHING steps when pipelining.
+			if (Index != NOTHING)
+#endif
+			{
+				Program->MS += HeldMS(Value) * Repeats[Depth];
+				Rounded     += (HeldMS(Value) - Value) * Repeats[Depth];
+			}
+
+			// The values line up like the rest of the table, e.g. "TAP(NOTHING,  48)" and "HOLD(B,      144)".
+			const char* Helper = (Value <= TAP_MAX_MS) ? "TAP" : "HOLD";
+			int Width = 16 - (int)strlen(Helper) - 1 - (int)strlen(InputSymbols[Index]) - 1;
+			Indent(Depth);
+			Append(&Source, "%s(%s,%*lu),\n", Helper, InputSymbols[Index], Width > 1 ? Width : 1, Value);
+
+			// This profile's tick is never finer than MACRO_TICK_MS_MIN, so the step fits in a HOLD.
+			if (MACRO_TICKS(Value) <= 0x0F)
+			{
+				Emit((Index << 4) | MACRO_TICKS(Value));
+			}
+			else
+			{
+				Emit(Index << 4);
+				Emit(MACRO_TICKS(Value));
+			}
+		}
+		else if (!strcmp(Command, "wait") || !strcmp(Command, "wait_settle") || !strcmp(Command, "wait_change") || !strcmp(Command, "wait_out"))
+		{
+			if (Count != 2 || !ParseMS(Tokens[1], &Value))
+			{
+				Error("expected '%s <ms>'", Command);
+				continue;
+			}
+			if (Value > WAIT_MAX_MS)
+			{
+				Error("%lu ms is too long for one wait (up to %lu ms)", Value, WAIT_MAX_MS);
+				continue;
+			}
+
+			// Host paced waits are charged for their whole timeout, that is what they cost when the host never answers.
+			Program->MS += HeldMS(Value) * Repeats[Depth];
+			Rounded     += (HeldMS(Value) - Value) * Repeats[Depth];
+
+			char Helper[MAX_NAME];
+			snprintf(Helper, sizeof(Helper), "%s", !strcmp(Command, "wait") ? "wait_ms" : Command);
+			for (char* Char = Helper; *Char; Char++)
+				*Char = toupper((unsigned char)*Char);
+
+			Indent(Depth);
+			Append(&Source, "%s(%lu),\n", Helper, Value);
+
+			if (!strcmp(Command, "wait"))
+				Emit(MACRO_OP(MOP_WAIT));
+			else if (!strcmp(Command, "wait_settle"))
+				Emit(MACRO_OP(MOP_WAIT_SETTLE));
+			else if (!strcmp(Command, "wait_change"))
+				Emit(MACRO_OP(MOP_WAIT_CHANGE));
+			else
+				Emit(MACRO_OP(MOP_WAIT_OUT));
+			EmitWord(MACRO_TICKS(Value));
+		}
+		else if (!strcmp(Command, "press"))
+		{
+			if (Count != 2)
+			{
+				Error("expected 'press <button>[+<button>...]'");
+				continue;
+			}
+
+			Indent(Depth);
+			Append(&Source, "PRESS(");
+			unsigned Pressed = 0;
+			uint16_t Mask    = 0;
+			for (char* Name = strtok(Tokens[1], "+"); Name; Name = strtok(NULL, "+"))
+			{
+				unsigned Button;
+				for (Button = 0; Button < sizeof(ButtonNames) / sizeof(ButtonNames[0]); Button++)
+				{
+					if (!strcmp(Name, ButtonNames[Button].Name))
+						break;
+				}
+
+				if (Button == sizeof(ButtonNames) / sizeof(ButtonNames[0]))
+				{
+					Error("unknown button '%s'", Name);
+					continue;
+				}
+
+				Append(&Source, "%s%s", Pressed++ ? " | " : "", ButtonNames[Button].Symbol);
+				Mask |= ButtonNames[Button].Mask;
+			}
+			Append(&Source, "),\n");
+
+			Emit(MACRO_OP(MOP_PRESS));
+			EmitWord(Mask);
+		}
+		else if (!strcmp(Command, "hat"))
+		{
+			if (Count != 2 || Find(Tokens[1], HATNames, sizeof(HATNames) / sizeof(HATNames[0])) < 0)
+			{
+				Error("expected 'hat <direction>'");
+				continue;
+			}
+
+			Indent(Depth);
+			Append(&Source, "PRESS_HAT(HAT_%s),\n", Tokens[1]);
+
+			// The HAT_* values are in the same order as their names.
+			Emit(MACRO_OP(MOP_HAT));
+			Emit(Find(Tokens[1], HATNames, sizeof(HATNames) / sizeof(HATNames[0])));
+		}
+		else if (!strcmp(Command, "stick"))
+		{
+			static const char* const StickNames[] = { "LEFT", "RIGHT" };
+			static const char* const AxisNames[]  = { "MIN", "CENTER", "MAX" };
+			static const uint8_t     AxisValues[] = { STICK_MIN, STICK_CENTER, STICK_MAX };
+			int      Stick = (Count == 4) ? Find(Tokens[1], StickNames, 2) : -1;
+			unsigned Axes[2];
+			bool     Valid = Stick >= 0;
+
+			for (unsigned Axis = 0; Valid && Axis < 2; Axis++)
+			{
+				const char* Token = Tokens[2 + Axis];
+				char*       End;
+				int         Name = Find(Token, AxisNames, 3);
+
+				Axes[Axis] = (Name >= 0) ? AxisValues[Name] : strtoul(Token, &End, 10);
+				Valid = Name >= 0 || (End != Token && !*End && Axes[Axis] <= STICK_MAX);
+			}
+			if (!Valid)
+			{
+				Error("expected 'stick <LEFT|RIGHT> <x> <y>' with positions from 0 to 255, MIN, CENTER or MAX");
+				continue;
+			}
+
+			Indent(Depth);
+			Append(&Source, "STICK(MACRO_STICK_%s, ", StickNames[Stick]);
+			for (unsigned Axis = 0; Axis < 2; Axis++)
+			{
+				int Name = Find(Tokens[2 + Axis], AxisNames, 3);
+
+				if (Name >= 0)
+					Append(&Source, "STICK_%s%s", AxisNames[Name], Axis ? "),\n" : ", ");
+				else
+					Append(&Source, "%u%s", Axes[Axis], Axis ? "),\n" : ", ");
+			}
+
+			Emit(MACRO_OP(MOP_STICK));
+			Emit(Stick);
+			Emit(Axes[0]);
+			Emit(Axes[1]);
+		}
+		else if (!strcmp(Command, "release"))
+		{
+			Indent(Depth);
+			Append(&Source, "RELEASE,\n");
+			Emit(MACRO_OP(MOP_RELEASE));
+		}
+		else if (!strcmp(Command, "repeat"))
+		{
+			if (Count != 2 || !ParseCount(Tokens[1], &Value))
+				continue;
+			if (Depth == MACRO_MAX_DEPTH)
+			{
+				Error("repeat blocks nest at most %u deep", MACRO_MAX_DEPTH);
+				continue;
+			}
+
+			Indent(Depth);
+			Append(&Source, "REPEAT(%s),\n", Tokens[1]);
+			Emit(MACRO_OP(MOP_REPEAT));
+			Emit(Value);
+			Depth++;
+			Repeats[Depth] = Repeats[Depth - 1] * Value;
+		}
+		else if (!strcmp(Command, "loop"))
+		{
+			if (!Depth)
+			{
+				Error("loop without a repeat");
+				continue;
+			}
+
+			Depth--;
+			Indent(Depth);
+			Append(&Source, "LOOP,\n");
+			Emit(MACRO_OP(MOP_LOOP));
+		}
+		else if (!strcmp(Command, "label") || !strcmp(Command, "jump"))
+		{
+			unsigned Label;
+
+			if (Count != 2 || !IsIdentifier(Tokens[1]))
+			{
+				Error("expected '%s <name>'", Command);
+				continue;
+			}
+
+			for (Label = 0; Label < LabelCount; Label++)
+			{
+				if (!strcmp(Labels[Label], Tokens[1]))
+					break;
+			}
+			if (Label == LabelCount)
+			{
+				if (LabelCount == MAX_LABELS)
+				{
+					Error("too many labels in %s", Program->Name);
+					continue;
+				}
+
+				strcpy(Labels[LabelCount], Tokens[1]);
+				LabelLines[LabelCount] = LineNumber;
+				LabelCount++;
+			}
+
+			if (!strcmp(Command, "label"))
+			{
+				if (Defined[Label])
+					Error("label %s is already defined in %s", Tokens[1], Program->Name);
+				Defined[Label] = true;
+			}
+			else if (!Defined[Label])
+			{
+				// Jumping forwards is fine, but it's only checked at the end of the program.
+				LabelLines[Label] = LineNumber;
+			}
+
+			if (!Program->Jumps)
+				Program->Jumps = LineNumber;
+
+			// Time spent after jumps can't be worked out without running the program, macro-cost does that.
+			Indent(Depth);
+			Append(&Source, "%s(%u), // %s\n", !strcmp(Command, "label") ? "LABEL" : "JUMP", Label, Tokens[1]);
+			Emit(MACRO_OP(!strcmp(Command, "label") ? MOP_LABEL : MOP_JUMP));
+			Emit(Label);
+		}
+		else if (!strcmp(Command, "count"))
+		{
+			if (Count != 2 || strcmp(Tokens[1], "turns") != 0)
+			{
+				Error("expected 'count turns'");
+				continue;
+			}
+
+			Indent(Depth);
+			Append(&Source, "COUNT(COUNTER_TURNS),\n");
+			Emit(MACRO_OP(MOP_COUNT));
+			Emit(COUNTER_TURNS);
+		}
+		else
+		{
+			Error("unknown instruction '%s'", Command);
+		}
+	}
+
+	Error("%s has no end", Program->Name);
+}
+
+// Returns the program with the given name, or NULL after reporting that the match plays a program that doesn't exist.
+static const Program_t* MatchProgram(const char* const Name)
+{
+	for (unsigned Index = 0; Index < ProgramCount; Index++)
+	{
+		if (!strcmp(Programs[Index].Name, Name))
+			return &Programs[Index];
+	}
+
+	Error("the match plays %s, which isn't a program", Name);
+	return NULL;
+}
+
+// Reads one phase of the "match" line: the program it plays first, the one played in its place from the
+// second run on in builds with QUICK_PASS, and how many runs it has. Returns false after reporting a mistake.
+static bool MatchPhase(const char* const Phase, const Program_t** const First, const Program_t** const Rest, unsigned long* const Runs)
+{
+	char  Name[2 * MAX_NAME];
+	char* Times;
+	char* Again;
+
+	*Runs = 1;
+	snprintf(Name, sizeof(Name), "%s", Phase);
+	if ((Times = strchr(Name, '*')))
+	{
+		*Times = '\0';
+		if (!ParseCount(Times + 1, Runs))
+			return false;
+	}
+	if ((Again = strchr(Name, '/')))
+		*Again++ = '\0';
+
+	*First = MatchProgram(Name);
+	*Rest  = Again ? MatchProgram(Again) : *First;
+#ifndef QUICK_PASS
+	*Rest  = *First;
+#endif
+	return *First && *Rest;
+}
+
+// Prints the time a match takes, going by the phases listed on the "match" line.
+static void PrintMatch(char* const* const Phases, const unsigned Count, const unsigned MatchLine)
+{
+	unsigned long MS = 0;
+
+	LineNumber = MatchLine;
+	for (unsigned Phase = 0; Phase < Count; Phase++)
+	{
+		const Program_t* First;
+		const Program_t* Rest;
+		unsigned long    Runs;
+
+		if (!MatchPhase(Phases[Phase], &First, &Rest, &Runs))
+			return;
+
+		MS += First->MS + Rest->MS * (Runs - 1);
+	}
+
+#ifndef MACRO_PIPELINE
+	// The firmware spends one report breathing between matches.
+	MS += REPORT_WINDOW_MS;
+#endif
+
+	printf("  %-16s %7lu ms (%lu matches per hour on input time alone)\n", "match", MS, MS ? 3600000UL / MS : 0);
+}
+
+// Writes the buffer to the named file. Returns false if that didn't work.
+static bool WriteFile(const char* const Name, const Buffer_t* const Buffer)
+{
+	FILE* File = fopen(Name, "wb");
+
+	if (!File || fwrite(Buffer->Data, 1, Buffer->Length, File) != Buffer->Length || fclose(File) != 0)
+	{
+		perror(Name);
+		return false;
+	}
+
+	return true;
+}
+
+// Lays out the EEPROM profile: the header of Profile.h, little endian, followed by the bytecode.
+static void BuildProfile(Buffer_t* const Profile)
+{
+	static const char* const Names[PROFILE_PROGRAMS] = PROFILE_PROGRAM_NAMES;
+	uint8_t Header[sizeof(Profile_Header_t)] = { 0 };
+	uint8_t Sum = 0;
+
+	Header[offsetof(Profile_Header_t, Magic)]            = PROFILE_MAGIC & 0xFF;
+	Header[offsetof(Profile_Header_t, Magic) + 1]        = PROFILE_MAGIC >> 8;
+	Header[offsetof(Profile_Header_t, Version)]          = PROFILE_VERSION;
+	Header[offsetof(Profile_Header_t, Length)]           = Code.Length & 0xFF;
+	Header[offsetof(Profile_Header_t, Length) + 1]       = Code.Length >> 8;
+	Header[offsetof(Profile_Header_t, TickMS)]           = MACRO_TICK_MS;
+	Header[offsetof(Profile_Header_t, PressScale)]       = PressScale;
+	Header[offsetof(Profile_Header_t, ReleaseScale)]     = ReleaseScale;
+
+	for (unsigned Slot = 0; Slot < PROFILE_PROGRAMS; Slot++)
+	{
+		uint16_t Offset = PROFILE_BUILT_IN;
+
+		for (unsigned Index = 0; Index < ProgramCount; Index++)
+		{
+			if (!strcmp(Programs[Index].Name, Names[Slot]))
+				Offset = Programs[Index].Offset;
+		}
+		if (Offset == PROFILE_BUILT_IN)
+			printf("profile: no %s program, units keep their built-in one\n", Names[Slot]);
+
+		Header[offsetof(Profile_Header_t, Programs) + Slot * 2]     = Offset & 0xFF;
+		Header[offsetof(Profile_Header_t, Programs) + Slot * 2 + 1] = Offset >> 8;
+	}
+
+	for (size_t Byte = 0; Byte < sizeof(Header); Byte++)
+		Sum += Header[Byte];
+	for (size_t Byte = 0; Byte < Code.Length; Byte++)
+		Sum += (uint8_t)Code.Data[Byte];
+	Header[offsetof(Profile_Header_t, Checksum)] = -Sum;
+
+	for (size_t Byte = 0; Byte < sizeof(Header); Byte++)
+		AppendByte(Profile, Header[Byte]);
+	for (size_t Byte = 0; Byte < Code.Length; Byte++)
+		AppendByte(Profile, Code.Data[Byte]);
+}
+
+// Returns the size in bytes of the instruction starting with the given byte, as Macro.c reads it.
+static unsigned InstructionLength(const uint8_t Op)
+{
+	if ((Op >> 4) != MACRO_INPUT_RESERVED)
+		return (Op & 0x0F) ? 1 : 2;
+
+	switch (Op & 0x0F)
+	{
+		case MOP_REPEAT:
+		case MOP_LABEL:
+		case MOP_JUMP:
+		case MOP_HAT:
+		case MOP_COUNT:
+			return 2;
+		case MOP_WAIT:
+		case MOP_PRESS:
+		case MOP_WAIT_SETTLE:
+		case MOP_WAIT_CHANGE:
+		case MOP_WAIT_OUT:
+			return 3;
+		case MOP_STICK:
+			return 4;
+		default:
+			return 1;
+	}
+}
+
+static size_t Unroll(const uint8_t* const Program, size_t Offset, Buffer_t* const Stream);
+
+// Writes out one match for the stream, the phases of the "match" line played in order as a single program.
+// The firmware takes every END of a stream for the end of a match, back on the deck select screen, so only
+// the last phase keeps its END, and programs the match doesn't play, such as recover[], are left out.
+static void StreamMatch(char* const* const Phases, const unsigned Count, const unsigned MatchLine, Buffer_t* const Stream)
+{
+	LineNumber = MatchLine;
+	for (unsigned Phase = 0; Phase < Count; Phase++)
+	{
+		const Program_t* First;
+		const Program_t* Rest;
+		unsigned long    Runs;
+
+		if (!MatchPhase(Phases[Phase], &First, &Rest, &Runs))
+			return;
+
+		for (unsigned long Run = 0; Run < Runs; Run++)
+		{
+			const Program_t* const Program = Run ? Rest : First;
+
+			if (Program->Jumps)
+			{
+				LineNumber = Program->Jumps;
+				Error("%s jumps, which a stream can't do", Program->Name);
+				return;
+			}
+
+			Unroll((const uint8_t*)Code.Data, Program->Offset, Stream);
+			if (Phase + 1 < Count || Run + 1 < Runs)
+				Stream->Length--;
+		}
+	}
+}
+
+// Writes the bytecode from the given offset up to the end of the program or of the repeat block it is in,
+// with every repeat block inside written out as many times as it runs. Returns the offset after it.
+static size_t Unroll(const uint8_t* const Program, size_t Offset, Buffer_t* const Stream)
+{
+	for (;;)
+	{
+		const uint8_t Op = Program[Offset];
+
+		if (Op == MACRO_OP(MOP_REPEAT))
+		{
+			size_t After = Offset;
+
+			for (unsigned Run = 0; Run < Program[Offset + 1]; Run++)
+				After = Unroll(Program, Offset + 2, Stream);
+			Offset = After;
+			continue;
+		}
+		if (Op == MACRO_OP(MOP_LOOP))
+			return Offset + 1;
+
+		for (unsigned Byte = 0; Byte < InstructionLength(Op); Byte++)
+			AppendByte(Stream, Program[Offset + Byte]);
+		if (Op == MACRO_OP(MOP_END))
+			return Offset + 1;
+		Offset += InstructionLength(Op);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* ProfileName = NULL;
+	const char* StreamName  = NULL;
+	int         Option;
+
+	while ((Option = getopt(argc, argv, "p:s:")) != -1)
+	{
+		if (Option == 'p')
+			ProfileName = optarg;
+		else if (Option == 's')
+			StreamName = optarg;
+		else
+			break;
+	}
+
+	if (Option != -1 || !(argc - optind == 3 || ((ProfileName || StreamName) && argc - optind == 1)))
+	{
+		fprintf(stderr, "Usage: %s [-p profile.bin] [-s stream.bin] script.mac [output.c output.h]\n", argv[0]);
+		return 1;
+	}
+
+	const char* SourceName = (argc - optind == 3) ? argv[optind + 1] : NULL;
+	const char* HeaderPath = (argc - optind == 3) ? argv[optind + 2] : "Macros.h";
+
+	Script = argv[optind];
+	FILE* File = fopen(Script, "r");
+	if (!File)
+	{
+		perror(Script);
+		return 1;
+	}
+
+	const char* HeaderName = strrchr(HeaderPath, '/') ? strrchr(HeaderPath, '/') + 1 : HeaderPath;
+
+	Append(&Source, "/** \\file\n *\n *  Macro programs replayed by the firmware.\n *\n");
+	Append(&Source, " *  Generated by Tools/macroc from %s, edit that file instead.\n */\n\n", Script);
+	Append(&Source, "#include \"%s\"\n", HeaderName);
+
+	Append(&Header, "/** \\file\n *\n *  Header file for the macro programs in Macros.c.\n *\n");
+	Append(&Header, " *  Generated by Tools/macroc from %s, edit that file instead.\n */\n\n", Script);
+	Append(&Header, "#ifndef _MACROS_H_\n#define _MACROS_H_\n\n/* Includes: */\n#include \"Macro.h\"\n\n");
+	Append(&Header, "// Macro programs\n");
+
+	printf("Macro times (%u ms polling, %u echoes, %u ms per report):\n", POLLING_MS, ECHOES, REPORT_WINDOW_MS);
+
+	char     Line[MAX_LINE];
+	char     Comments[MAX_LINE * 8] = "";
+	char     Match[MAX_LINE] = "";
+	unsigned MatchLine = 0;
+
+	while (fgets(Line, sizeof(Line), File))
+	{
+		char* Token;
+
+		LineNumber++;
+		Line[strcspn(Line, "\r\n")] = '\0';
+
+		// A block of comments is kept if it sits right above a program.
+		if (Line[0] == '#')
+		{
+			if (strlen(Comments) + strlen(Line) + 4 < sizeof(Comments))
+			{
+				strcat(Comments, "//");
+				strcat(Comments, Line + 1);
+				strcat(Comments, "\n");
+			}
+			continue;
+		}
+
+		Line[strcspn(Line, "#")] = '\0';
+		if (!(Token = strtok(Line, " \t")))
+		{
+			Comments[0] = '\0';
+			continue;
+		}
+
+		if (!strcmp(Token, "program"))
+		{
+			char* Name = strtok(NULL, " \t");
+
+			if (!Name || !IsIdentifier(Name) || strtok(NULL, " \t"))
+			{
+				Error("expected 'program <name>'");
+				Name = "invalid";
+			}
+			for (unsigned Index = 0; Index < ProgramCount; Index++)
+			{
+				if (!strcmp(Programs[Index].Name, Name))
+					Error("there already is a program called %s", Name);
+			}
+			if (ProgramCount == MAX_PROGRAMS)
+			{
+				Error("too many programs, there can be up to %u", MAX_PROGRAMS);
+				break;
+			}
+
+			Program_t* Program = &Programs[ProgramCount++];
+			snprintf(Program->Name, sizeof(Program->Name), "%s", Name);
+			Program->MS    = 0;
+			Program->Jumps = 0;
+
+			Append(&Source, "\n%s", Comments);
+			Comments[0] = '\0';
+			CompileProgram(File, Program);
+		}
+		else if (!strcmp(Token, "match"))
+		{
+			char* Rest = strtok(NULL, "");
+			snprintf(Match, sizeof(Match), "%s", Rest ? Rest : "");
+			MatchLine = LineNumber;
+			Comments[0] = '\0';
+		}
+		else if (!strcmp(Token, "scale"))
+		{
+			char* Press   = strtok(NULL, " \t");
+			char* Release = strtok(NULL, " \t");
+			char* End     = NULL;
+
+			if (!Press || !Release || strtok(NULL, " \t") ||
+			    (PressScale = strtoul(Press, &End, 10)) < 1 || PressScale > 0xFF || *End ||
+			    (ReleaseScale = strtoul(Release, &End, 10)) < 1 || ReleaseScale > 0xFF || *End)
+			{
+				Error("expected 'scale <press %%> <release %%>' with percentages from 1 to 255");
+			}
+			Comments[0] = '\0';
+		}
+		else
+		{
+			Error("expected 'program <name>', 'match <phase>...' or 'scale <press %%> <release %%>', not '%s'", Token);
+		}
+	}
+	fclose(File);
+
+	char*    Phases[MAX_PROGRAMS * 2];
+	unsigned Count = 0;
+	if (MatchLine)
+	{
+		for (char* Phase = strtok(Match, " \t"); Phase && Count < sizeof(Phases) / sizeof(Phases[0]); Phase = strtok(NULL, " \t"))
+			Phases[Count++] = Phase;
+
+		PrintMatch(Phases, Count, MatchLine);
+	}
+
+	Append(&Header, "\n#endif\n");
+
+	if (Warnings)
+		fprintf(stderr, "%s: %u warning(s)\n", Script, Warnings);
+
+	if (ProfileName)
+	{
+		if (Code.Length > PROFILE_CODE_SIZE)
+			Error("the programs take %zu bytes, more than the %u an EEPROM profile holds", Code.Length, (unsigned)PROFILE_CODE_SIZE);
+		else
+			printf("profile: %zu of %u bytes, scaled %lu%% / %lu%%\n", Code.Length, (unsigned)PROFILE_CODE_SIZE, PressScale, ReleaseScale);
+	}
+
+	Buffer_t Stream = { 0 };
+	if (StreamName && !Errors)
+	{
+		if (!Count)
+			Error("a stream plays the phases of the match line, and there is none");
+		else
+			StreamMatch(Phases, Count, MatchLine, &Stream);
+		if (!Errors)
+			printf("stream: one match of %zu bytes\n", Stream.Length);
+	}
+
+	if (Errors)
+	{
+		fprintf(stderr, "%s: %u error(s), nothing written\n", Script, Errors);
+		return 1;
+	}
+
+	if (StreamName && !WriteFile(StreamName, &Stream))
+		return 1;
+
+	if (ProfileName)
+	{
+		Buffer_t Profile = { 0 };
+
+		BuildProfile(&Profile);
+		if (!WriteFile(ProfileName, &Profile))
+			return 1;
+	}
+
+	if (SourceName && !(WriteFile(SourceName, &Source) && WriteFile(HeaderPath, &Header)))
+		return 1;
+
+	return 0;
+}
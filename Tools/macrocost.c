@@ -0,0 +1,129 @@
+/*
+ * Build-time report of what every step of the macro costs on the wire.
+ *
+ * This runs the firmware's own interpreter (Macro.c) over each phase program against
+ * a virtual clock. The firmware builds one report per report window (POLLING_MS * (1 + ECHOES)),
+ * and a step can only change between reports, so each step is charged for the
+ * whole number of report windows it is actually held for.
+ *
+ * Build it with the same -D flags as the firmware, as the makefile's macro-cost target does.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Macro.h"
+#include "Macros.c"
+
+// The interpreter can also run programs from EEPROM, but only the built-in ones are costed here.
+uint8_t Shim_EEPROM[E2END + 1];
+
+static const char* const InputNames[] = { "UP", "DOWN", "LEFT", "RIGHT", "A", "B", "NOTHING", "A+UP", "A+DOWN", "A+LEFT", "A+RIGHT", "B+UP", "B+DOWN", "B+LEFT", "B+RIGHT" };
+static const char* const OpNames[]    = { "END", "REPEAT", "LOOP", "LABEL", "JUMP", "WAIT", "PRESS", "HAT", "RELEASE", "WAIT_SETTLE", "WAIT_CHANGE", "WAIT_OUT", "COUNT", "STICK" };
+_Static_assert(sizeof(OpNames) / sizeof(OpNames[0]) == MOP_OPCODES, "OpNames[] has to name every MacroOpcodes_t");
+
+static void PrintInstruction(const uint8_t* const Address)
+{
+	uint8_t Op = Address[0];
+
+	if ((Op >> 4) != MACRO_INPUT_RESERVED)
+	{
+		unsigned Ticks = (Op & 0x0F) ? (Op & 0x0F) : Address[1];
+		printf("%-4s %-8s %5u ms", (Op & 0x0F) ? "TAP" : "HOLD", InputNames[Op >> 4], Ticks * MACRO_TICK_MS);
+	}
+	else if ((Op & 0x0F) < sizeof(OpNames) / sizeof(OpNames[0]))
+	{
+		printf("%-22s", OpNames[Op & 0x0F]);
+	}
+}
+
+// Runs one program to its end, prints what each of its steps cost and returns its total in reports.
+static unsigned CostProgram(const char* const Name, const uint8_t* const Program, const unsigned Size)
+{
+	static unsigned Starts[256];
+	static unsigned Windows[256];
+	static unsigned Gaps[256];
+
+	Macro_t  Macro;
+	Clock_ms_t Now     = 0;
+	unsigned   Reports = 0;
+
+	memset(Starts, 0, sizeof(Starts));
+	memset(Windows, 0, sizeof(Windows));
+	memset(Gaps, 0, sizeof(Gaps));
+
+	if (Size > sizeof(Starts) / sizeof(Starts[0]))
+	{
+		printf("%s: %u bytes, too long to cost\n", Name, Size);
+		return 0;
+	}
+
+	Macro_Start(&Macro, MACRO_FLASH, Program, Now);
+
+	uint16_t   LastPC      = UINT16_MAX;
+	Clock_ms_t LastStarted = 0;
+
+	for (;;)
+	{
+		USB_JoystickReport_Input_t Report = { .HAT = HAT_CENTER };
+
+		if (!Macro_Run(&Macro, &Report, Now))
+			break;
+
+		// A pipelined release gap shows up as the step it comes before, with nothing held.
+		uint8_t Op  = Program[Macro.StepPC];
+		bool    Gap = ((Op >> 4) != MACRO_INPUT_RESERVED) && ((Op >> 4) != Macro.StepInput);
+
+		if (!Gap && (Macro.StepPC != LastPC || Macro.StepStarted != LastStarted))
+			Starts[Macro.StepPC]++;
+
+		LastPC      = Macro.StepPC;
+		LastStarted = Macro.StepStarted;
+
+		Windows[Macro.StepPC]++;
+		if (Gap)
+			Gaps[Macro.StepPC]++;
+		Reports++;
+		Now += REPORT_WINDOW_MS;
+	}
+
+	printf("%s:\n", Name);
+	printf("  %4s  %-22s %6s %8s %8s %8s\n", "PC", "Step", "Runs", "Reports", "Gap", "Total");
+
+	for (unsigned PC = 0; PC < Size; PC++)
+	{
+		if (!Starts[PC])
+			continue;
+
+		printf("  %4u  ", PC);
+		PrintInstruction(&Program[PC]);
+		printf(" %6u %8u %8u %5u ms\n", Starts[PC], Windows[PC], Gaps[PC], Windows[PC] * REPORT_WINDOW_MS);
+	}
+
+	printf("  Phase: %u reports, %u ms\n", Reports, Reports * REPORT_WINDOW_MS);
+	return Reports;
+}
+
+int main(void)
+{
+	unsigned Reports = 0;
+
+	printf("Macro step costs (%u ms polling, %u echoes, %u ms per report):\n", POLLING_MS, ECHOES, REPORT_WINDOW_MS);
+
+	// The same phases, in the same order, as a match played by GetNextReport().
+	Reports += CostProgram("deck_select", deck_select, sizeof(deck_select));
+	Reports += CostProgram("pass_turn", pass_turn, sizeof(pass_turn)) * TURNS;
+	Reports += CostProgram("results", results, sizeof(results));
+	Reports += CostProgram("popups", popups, sizeof(popups));
+	Reports += CostProgram("rematch", rematch, sizeof(rematch));
+
+#ifndef MACRO_PIPELINE
+	// The firmware spends one report breathing between matches.
+	Reports++;
+#endif
+
+	printf("Match: %u reports, %u ms (%u turns)\n", Reports, Reports * REPORT_WINDOW_MS, TURNS);
+
+	CostProgram("recover", recover, sizeof(recover));
+	return 0;
+}
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""Regression suite for the firmware's footprint and the macro's throughput, run by make regress.
+
+For every MCU, builds the firmware and checks its flash and RAM against what the part has room
+for. For every timing profile, runs the host simulator and checks the input time per match
+against Tools/regress-baseline.txt, so a change that makes the macro slower fails. With --units,
+also reads the worst HID_Task() run of every connected unit flashed with make profile.
+Exits with 1 if any check fails. Checks whose tools are missing (avr-size, pyusb) are skipped.
+
+    regress.py [--mcus "atmega16u2 ..."] [--seconds S] [--units] [--update]
+"""
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "regress-baseline.txt")
+
+# Flash left for the firmware next to each part's stock bootloader (DFU on the UNO R3's 16u2, Caterina
+# on the Arduino Micro's 32u4, HalfKay on the Teensy 2.0++), and its RAM.
+MCU_FLASH = {"atmega16u2": 16384 - 4096, "atmega32u4": 32768 - 4096, "at90usb1286": 131072 - 1024}
+MCU_RAM = {"atmega16u2": 512, "atmega32u4": 2560, "at90usb1286": 8192}
+# RAM that .data and .bss must leave to the stack: control requests and the USB interrupt nest on top
+# of the report builder.
+STACK_RESERVE = 128
+
+# Timing profiles of Config/Timing.h, by their TIMING_PROFILE name in the makefile.
+PROFILES = ("conservative", "default", "fast")
+
+# Worst HID_Task() run allowed, in CPU cycles: half of the fast profile's 1 ms poll interval at 16 MHz,
+# which leaves the other half for building the next report.
+MAX_HID_CYCLES = 8000
+
+MAKE = os.environ.get("MAKE", "make")
+
+
+def make(*args):
+    result = subprocess.run([MAKE, "-s"] + list(args), stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                            universal_newlines=True)
+    if result.returncode:
+        sys.stderr.write(result.stderr)
+        raise RuntimeError("make %s failed" % " ".join(args))
+    return result.stderr
+
+
+def check_sizes(mcus):
+    if not shutil.which("avr-size"):
+        print("footprint: skipped, no avr-size")
+        return True
+
+    ok = True
+    try:
+        for mcu in mcus:
+            make("clean")
+            make("MCU=" + mcu, "Joystick.elf")
+            sizes = subprocess.run(["avr-size", "-C", "--mcu=" + mcu, "Joystick.elf"], stdout=subprocess.PIPE,
+                                   universal_newlines=True, check=True).stdout
+            flash = int(re.search(r"^Program:\s+(\d+)", sizes, re.M).group(1))
+            ram = int(re.search(r"^Data:\s+(\d+)", sizes, re.M).group(1))
+            flash_ok = flash <= MCU_FLASH[mcu]
+            ram_ok = ram <= MCU_RAM[mcu] - STACK_RESERVE
+            print("footprint %-12s flash %6d of %6d bytes%s  RAM %5d of %5d bytes%s"
+                  % (mcu, flash, MCU_FLASH[mcu], "" if flash_ok else " FAIL",
+                     ram, MCU_RAM[mcu] - STACK_RESERVE, "" if ram_ok else " FAIL"))
+            ok = ok and flash_ok and ram_ok
+    finally:
+        make("clean")
+
+    return ok
+
+
+def simulate(profile, seconds):
+    summary = make("sim", "TIMING_PROFILE=" + profile, "SIM_SECONDS=%d" % seconds)
+    counters = re.search(r"^Device counters: (\d+) matches, \d+ turns, (\d+) reports", summary, re.M)
+    match = re.search(r"^Matches: \d+, ([\d.]+) s of input per \d+ turn match \((\d+) matches per hour", summary, re.M)
+    if not counters or not match or not int(counters.group(1)):
+        raise RuntimeError("the %s simulation played no match" % profile)
+    return {"match_s": float(match.group(1)), "per_hour": int(match.group(2)),
+            "reports_per_match": int(counters.group(2)) // int(counters.group(1))}
+
+
+def read_baseline(seconds):
+    baseline = {}
+    if not os.path.exists(BASELINE):
+        return baseline
+    with open(BASELINE) as f:
+        for line in f:
+            fields = line.split()
+            if not fields or fields[0].startswith("#"):
+                continue
+            if fields[0] == "seconds":
+                if int(fields[1]) != seconds:
+                    sys.exit("%s was recorded over %s simulated seconds, not %d" % (BASELINE, fields[1], seconds))
+                continue
+            baseline[fields[0]] = float(fields[1])
+    return baseline
+
+
+def check_simulation(seconds, update):
+    baseline = {} if update else read_baseline(seconds)
+    results = {}
+    ok = True
+
+    for profile in PROFILES:
+        result = results[profile] = simulate(profile, seconds)
+        limit = baseline.get(profile)
+        slower = limit is not None and result["match_s"] > limit
+        print("simulated %-12s %7.3f s per match%s  %3d matches per hour  %6d reports per match%s"
+              % (profile, result["match_s"], " (baseline %.3f)" % limit if limit is not None else "",
+                 result["per_hour"], result["reports_per_match"], " FAIL, slower" if slower else ""))
+        ok = ok and not slower
+
+    if update:
+        with open(BASELINE, "w") as f:
+            f.write("# Simulated seconds of input per match for each timing profile, written by make regress-baseline.\n")
+            f.write("# make regress fails once a profile takes longer than this.\n")
+            f.write("seconds %d\n" % seconds)
+            for profile in PROFILES:
+                f.write("%s %.3f\n" % (profile, results[profile]["match_s"]))
+        print("baseline written to %s" % BASELINE)
+
+    return ok
+
+
+def check_units():
+    try:
+        import splatctl
+    except ImportError:
+        print("cycles: skipped, no pyusb")
+        return True
+
+    ok = True
+    for dev in splatctl.find_units():
+        probes = splatctl.read_probes(dev)
+        if probes is None:
+            print("cycles %-16s skipped, not a profiling build (make profile)" % splatctl.unit_name(dev))
+            continue
+        name, low, high, average, runs = probes["probes"][0]
+        fits = high <= MAX_HID_CYCLES
+        print("cycles %-16s %s worst %d of %d cycles over %d runs%s"
+              % (splatctl.unit_name(dev), name, high, MAX_HID_CYCLES, runs, "" if fits else " FAIL"))
+        ok = ok and fits
+
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--mcus", default=" ".join(MCU_FLASH), help="MCUs to build for, separated by spaces")
+    parser.add_argument("--seconds", type=int, default=3600, help="simulated run time of each timing profile")
+    parser.add_argument("--units", action="store_true", help="also check the cycle counts of connected profiling units")
+    parser.add_argument("--update", action="store_true", help="record the simulated match times as the new baseline")
+    args = parser.parse_args()
+
+    unknown = [mcu for mcu in args.mcus.split() if mcu not in MCU_FLASH]
+    if unknown:
+        sys.exit("no flash and RAM sizes for %s" % " ".join(unknown))
+
+    try:
+        ok = check_sizes(args.mcus.split())
+        ok = check_simulation(args.seconds, args.update) and ok
+        if args.units:
+            ok = check_units() and ok
+    except RuntimeError as error:
+        sys.exit(str(error))
+
+    if not ok:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
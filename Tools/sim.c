@@ -0,0 +1,628 @@
+/*
+ * Host-side simulator for the firmware's report state machine.
+ *
+ * Joystick.c, the interpreter and the macro tables are built natively against the
+ * stand-in headers in Tools/Shim, with the same -D flags as the firmware. This file
+ * plays the host: it runs a virtual millisecond clock, configures the device, polls
+ * the IN endpoint of every pad and optionally sends them OUT reports. Every time the
+ * report on the wire changes, a timestamped line is printed to stdout. A throughput
+ * summary goes to stderr at the end.
+ *
+ * Usage: sim [-s seconds] [-p poll_ms] [-o out_ms] [-e profile] [-i stream] [-t percent] [-q]
+ *   -s  Virtual time to run for (default 1200 s)
+ *   -p  Interval the host polls the IN endpoint at (default POLLING_MS)
+ *   -o  Interval the host sends OUT reports at, mirroring our input (default never)
+ *   -e  EEPROM profile (from macroc -p) to write to the device before it starts
+ *   -i  Bytecode (from macroc -s) to send over the serial link at STREAM_BAUD, minding
+ *       XON/XOFF, in builds with SERIAL_STREAM
+ *   -t  In builds with AUTO_TUNE, play an operator who pulls TUNE_PIN low whenever a scale
+ *       has been tuned below this percentage, as if the game missed presses from there on
+ *   -q  Only print the summary
+ */
+
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Joystick.h"
+
+// Registers the firmware touches.
+volatile uint8_t  MCUSR, DDRB, PORTB, PINB, DDRD, PORTD, PIND, TCCR1A, TCCR1B, TIMSK1;
+volatile uint16_t OCR1A, TCNT1;
+volatile uint8_t  UCSR1B, UDR1;
+
+uint8_t Shim_EEPROM[E2END + 1];
+
+volatile uint8_t     USB_DeviceState = DEVICE_STATE_Unattached;
+USB_Request_Header_t USB_ControlRequest;
+
+// Data stage of the control request in progress.
+static uint8_t* ControlData;
+static uint16_t ControlLength;
+
+static uint32_t SimTime;
+static uint8_t  Selected;
+static bool     INReady[PADS];
+static bool     OUTReceived[PADS];
+static bool     Quiet;
+
+// The host end of the serial link, and what it sends.
+static struct {
+	uint8_t* Data;
+	size_t   Length;
+	size_t   Sent;
+	uint32_t Credit; // Bit times the link has had to send the next byte
+	bool     Paused; // We got XOFF and no XON since
+	uint32_t Pauses;
+} Serial;
+
+#ifdef AUTO_TUNE
+// The simulated operator holds the tune pin low this long (in ms), and doesn't step in again for a while after.
+#define OPERATOR_PULL_MS   200
+#define OPERATOR_REST_MS   5000
+// Their switch bounces for this long at either end of a pull.
+#define OPERATOR_BOUNCE_MS 10
+
+static struct {
+	unsigned Below;  // Scale, in %, below which the game misses presses
+	uint32_t Pulled; // When the operator last pulled the pin
+	bool     Pulling;
+	uint32_t Pulls;
+} Operator;
+#endif
+
+static USB_JoystickReport_Input_t Written[PADS];
+static USB_JoystickReport_Input_t OnWire[PADS];
+
+// What we've seen go out, for the summary.
+static struct {
+	uint32_t Reports;
+	uint32_t Changes;
+	uint32_t Presses[16];
+	uint32_t LastTurn;
+	uint32_t LastTurnMatch; // Matches played before the last turn
+	uint32_t Turns;
+	uint32_t TurnMS;       // Time between turns of the same match
+	uint32_t TimedTurns;   // and the turns passed in it, by every pad
+	uint32_t FirstMatch;
+	uint32_t FirstMatches; // Matches played by every pad when we first saw one end
+	uint32_t LastMatch;
+	uint32_t Matches;
+	uint32_t HeldMS;
+} Stats;
+
+static const char* const ButtonNames[16] = {
+	"Y", "B", "A", "X", "L", "R", "ZL", "ZR", "-", "+", "LS", "RS", "HOME", "CAP", "?", "?"
+};
+static const char* const HATNames[9] = { "U", "UR", "R", "DR", "D", "DL", "L", "UL", "-" };
+
+// Virtual clock, in place of Clock.c.
+void Clock_Init(void)
+{
+}
+
+Clock_ms_t Clock_Millis(void)
+{
+	return (Clock_ms_t)SimTime;
+}
+
+uint32_t Clock_Seconds(void)
+{
+	return SimTime / 1000;
+}
+
+#ifdef FRAME_CLOCK
+// Every simulated millisecond is a frame already.
+void Clock_Frame(void)
+{
+}
+#endif
+
+// Code takes no time here, so a profiling build only shows how often each probe ran.
+uint16_t Clock_Counts(void)
+{
+	return (uint16_t)(SimTime * CLOCK_COUNTS_PER_MS);
+}
+
+#ifdef SERIAL_STREAM
+// USART driver, in place of LUFA.
+void Serial_Init(const uint32_t BaudRate, const bool DoubleSpeed)
+{
+	(void)BaudRate; (void)DoubleSpeed;
+}
+
+void Serial_SendByte(const char DataByte)
+{
+	if (DataByte == STREAM_XOFF && !Serial.Paused)
+	{
+		Serial.Paused = true;
+		Serial.Pauses++;
+	}
+	else if (DataByte == STREAM_XON)
+	{
+		Serial.Paused = false;
+	}
+}
+
+void USART1_RX_vect(void);
+
+// Sends what a millisecond of the serial link carries (8N1, so 10 bits a byte) unless we've been told to pause.
+static void FeedSerial(void)
+{
+	if (Serial.Paused || Serial.Sent == Serial.Length)
+	{
+		Serial.Credit = 0;
+		return;
+	}
+
+	for (Serial.Credit += STREAM_BAUD / 1000; Serial.Credit >= 10 && !Serial.Paused && Serial.Sent < Serial.Length; Serial.Credit -= 10)
+	{
+		UDR1 = Serial.Data[Serial.Sent++];
+		USART1_RX_vect();
+	}
+}
+#endif
+
+// USB device driver, in place of LUFA.
+void USB_Init(void)
+{
+}
+
+// One frame per simulated millisecond.
+uint16_t USB_Device_GetFrameNumber(void)
+{
+	return SimTime & 0x7FF;
+}
+
+void USB_USBTask(void)
+{
+}
+
+void USB_Device_EnableSOFEvents(void)
+{
+}
+
+void USB_Device_DisableSOFEvents(void)
+{
+}
+
+bool Endpoint_ConfigureEndpoint(const uint8_t Address, const uint8_t Type, const uint16_t Size, const uint8_t Banks)
+{
+	(void)Address; (void)Type; (void)Size; (void)Banks;
+	return true;
+}
+
+uint8_t Endpoint_GetCurrentEndpoint(void)
+{
+	return Selected;
+}
+
+void Endpoint_SelectEndpoint(const uint8_t Address)
+{
+	Selected = Address;
+}
+
+// Pad whose IN or OUT endpoint is selected.
+static uint8_t SelectedPad(void)
+{
+	return ((Selected & ~ENDPOINT_DIR_IN) - 1) / 2;
+}
+
+bool Endpoint_IsINReady(void)
+{
+	return (Selected == PAD_IN_EPADDR(SelectedPad())) && INReady[SelectedPad()];
+}
+
+bool Endpoint_IsOUTReceived(void)
+{
+	return (Selected == PAD_OUT_EPADDR(SelectedPad())) && OUTReceived[SelectedPad()];
+}
+
+bool Endpoint_IsReadWriteAllowed(void)
+{
+	return true;
+}
+
+uint8_t Endpoint_Write_Stream_LE(const void* const Buffer, uint16_t Length, uint16_t* const BytesProcessed)
+{
+	(void)BytesProcessed;
+	memcpy(&Written[SelectedPad()], Buffer, Length < sizeof(Written[0]) ? Length : sizeof(Written[0]));
+	return 0;
+}
+
+uint8_t Endpoint_Read_Stream_LE(void* const Buffer, uint16_t Length, uint16_t* const BytesProcessed)
+{
+	(void)BytesProcessed;
+
+	// The console's OUT reports look like a mirror of what we sent it.
+	const USB_JoystickReport_Input_t* const Sent = &OnWire[SelectedPad()];
+	USB_JoystickReport_Output_t Mirror = {
+		.Button = Sent->Button, .HAT = Sent->HAT,
+		.LX = Sent->LX, .LY = Sent->LY, .RX = Sent->RX, .RY = Sent->RY
+	};
+	memset(Buffer, 0, Length);
+	memcpy(Buffer, &Mirror, Length < sizeof(Mirror) ? Length : sizeof(Mirror));
+	return 0;
+}
+
+void Endpoint_ClearOUT(void)
+{
+	OUTReceived[SelectedPad()] = false;
+}
+
+void Endpoint_ClearSETUP(void)
+{
+}
+
+void Endpoint_ClearStatusStage(void)
+{
+}
+
+void Endpoint_StallTransaction(void)
+{
+}
+
+uint8_t Endpoint_Write_Control_Stream_LE(const void* const Buffer, uint16_t Length)
+{
+	ControlLength = MIN(Length, ControlLength);
+	memcpy(ControlData, Buffer, ControlLength);
+	return 0;
+}
+
+uint8_t Endpoint_Read_Control_Stream_LE(void* const Buffer, uint16_t Length)
+{
+	memcpy(Buffer, ControlData, MIN(Length, ControlLength));
+	return 0;
+}
+
+// Sends the device a control request, the way a PC tool would. Returns the length of the data stage.
+static uint16_t ControlRequest(const uint8_t RequestType, const uint8_t Request, const uint16_t Value,
+                               const uint16_t Index, void* const Data, const uint16_t Length)
+{
+	USB_ControlRequest = (USB_Request_Header_t){
+		.bmRequestType = RequestType,
+		.bRequest      = Request,
+		.wValue        = Value,
+		.wIndex        = Index,
+		.wLength       = Length,
+	};
+
+	ControlData   = Data;
+	ControlLength = Length;
+	EVENT_USB_Device_ControlRequest();
+
+	return ControlLength;
+}
+
+// Writes a profile to the device and has it loaded, the way Tools/splatctl.py does.
+static void WriteProfile(const char* const Name)
+{
+	static const char* const StatusNames[] = { "none", "loaded", "bad version", "bad tick", "bad length", "bad scale", "bad checksum" };
+
+	uint8_t Data[E2END + 1];
+	uint8_t Status = UINT8_MAX;
+	FILE*   File   = fopen(Name, "rb");
+
+	if (!File)
+	{
+		perror(Name);
+		exit(1);
+	}
+	size_t Length = fread(Data, 1, sizeof(Data), File);
+	fclose(File);
+
+	for (size_t Offset = 0; Offset < Length; Offset += PROFILE_CHUNK_SIZE)
+	{
+		ControlRequest(REQDIR_HOSTTODEVICE | REQTYPE_VENDOR | REQREC_DEVICE, VENDOR_REQ_WriteProfile, Offset, 0,
+		               &Data[Offset], MIN(PROFILE_CHUNK_SIZE, Length - Offset));
+	}
+	ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE, VENDOR_REQ_LoadProfile, 0, 0, &Status, sizeof(Status));
+
+	fprintf(stderr, "Profile %s: %zu bytes written, %s\n", Name, Length,
+	        Status < sizeof(StatusNames) / sizeof(StatusNames[0]) ? StatusNames[Status] : "no answer");
+}
+
+static void PrintReport(const uint8_t Pad, const USB_JoystickReport_Input_t* const Report)
+{
+	printf("%7u.%03u ", SimTime / 1000, SimTime % 1000);
+	if (PADS > 1)
+		printf("pad%u ", Pad);
+
+	bool Any = false;
+	for (uint8_t Bit = 0; Bit < 16; Bit++)
+	{
+		if (Report->Button & (1 << Bit))
+		{
+			printf("%s%s", Any ? "+" : "", ButtonNames[Bit]);
+			Any = true;
+		}
+	}
+	if (!Any)
+		printf("-");
+
+	printf(" hat=%s sticks=%u,%u,%u,%u\n", HATNames[Report->HAT <= HAT_CENTER ? Report->HAT : HAT_CENTER],
+	       Report->LX, Report->LY, Report->RX, Report->RY);
+}
+
+// The host has taken the report we wrote.
+void Endpoint_ClearIN(void)
+{
+	const uint8_t                           Pad    = SelectedPad();
+	USB_JoystickReport_Input_t* const       Wire   = &OnWire[Pad];
+	const USB_JoystickReport_Input_t* const Report = &Written[Pad];
+
+	INReady[Pad] = false;
+	Stats.Reports++;
+
+	if (memcmp(Report, Wire, sizeof(*Wire)) != 0)
+	{
+		uint16_t Pressed = Report->Button & ~Wire->Button;
+		for (uint8_t Bit = 0; Bit < 16; Bit++)
+		{
+			if (Pressed & (1 << Bit))
+				Stats.Presses[Bit]++;
+		}
+
+		// The macro counts every turn it has passed and every match it has played. Turns are only timed
+		// against the one before them in the same match, the time in between matches is in the match time.
+		if (Counters.Turns != Stats.Turns)
+		{
+			if (Stats.Turns && Counters.Cycles == Stats.LastTurnMatch)
+			{
+				Stats.TurnMS     += SimTime - Stats.LastTurn;
+				Stats.TimedTurns += Counters.Turns - Stats.Turns;
+			}
+			Stats.Turns         = Counters.Turns;
+			Stats.LastTurn      = SimTime;
+			Stats.LastTurnMatch = Counters.Cycles;
+		}
+		if (Counters.Cycles != Stats.Matches)
+		{
+			if (!Stats.Matches)
+			{
+				Stats.FirstMatch   = SimTime;
+				Stats.FirstMatches = Counters.Cycles;
+			}
+			Stats.Matches   = Counters.Cycles;
+			Stats.LastMatch = SimTime;
+		}
+
+		*Wire = *Report;
+		Stats.Changes++;
+
+		if (!Quiet)
+			PrintReport(Pad, Wire);
+	}
+}
+
+static void PrintSummary(void)
+{
+	Counters_t Read = { 0 };
+	ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE, VENDOR_REQ_GetCounters, 0, 0, &Read, sizeof(Read));
+	fprintf(stderr, "Device counters: %u matches, %u turns, %u reports, %u syncs, %u recoveries, %u s up\n",
+	        Read.Cycles, Read.Turns, Read.Reports, Read.Syncs, Read.Recoveries, Read.Uptime);
+	if (PADS > 1)
+		fprintf(stderr, "%u pads: the counts below are totals over every pad, the time input is held is the first one's\n", PADS);
+
+#ifdef CYCLE_PROFILE
+	static const char* const ProbeNames[PROBE_COUNT] = { "HID_Task", "GetNextReport", "Macro_Run", "USB_USBTask" };
+	Probes_t Probed = { 0 };
+
+	ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE, VENDOR_REQ_GetProbes, 0, 0, &Probed, sizeof(Probed));
+	fprintf(stderr, "Probe runs:");
+	for (uint8_t Id = 0; Id < PROBE_COUNT; Id++)
+		fprintf(stderr, " %s=%u", ProbeNames[Id], Probed.Probes[Id].Runs);
+	fprintf(stderr, ", %u missed and %u late IN polls\n", Probed.MissedPolls, Probed.LatePolls);
+#endif
+
+#ifdef LATENCY_BENCH
+	Bench_t Benched = { 0 };
+
+	ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE, VENDOR_REQ_GetBench, 0, 0, &Benched, sizeof(Benched));
+	fprintf(stderr, "Bench%s, polling every %u ms (measured %u ms):\n", Benched.Done ? "" : " (not finished)", Benched.PollingMS, Benched.INInterval);
+	for (uint8_t Index = 0; Index < BENCH_ROWS; Index++)
+	{
+		const BenchRow_t* BenchRow = &Benched.Rows[Index];
+
+		fprintf(stderr, "  %u echoes: %u/%u registered, wire avg %u max %u, mirror avg %u max %u frames\n",
+		        BenchRow->Echoes, BenchRow->Registered, BenchRow->Presses,
+		        BenchRow->Presses ? BenchRow->WireTotal / BenchRow->Presses : 0, BenchRow->WireMax,
+		        BenchRow->Registered ? BenchRow->MirrorTotal / BenchRow->Registered : 0, BenchRow->MirrorMax);
+	}
+#endif
+
+#ifdef AUTO_TUNE
+	fprintf(stderr, "Tuning: press %u%%, release %u%% after %u pulls, profile status %u\n",
+	        MacroTiming.PressScale, MacroTiming.ReleaseScale, Operator.Pulls, Profile_Status);
+#endif
+
+#ifdef RIVAL_ROTATION
+	fprintf(stderr, "Rival rotation: playing rival %u of %u\n", Read.Rival, RIVALS);
+#endif
+
+#ifdef EVENT_TRACE
+	static const char* const TraceNames[] = { "boot", "connect", "disconnect", "suspend", "wakeup", "configured",
+	                                          "state", "program", "cut", "late-in" };
+	Trace_t Traced = { 0 };
+
+	ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_VENDOR | REQREC_DEVICE, VENDOR_REQ_GetTrace, 0, 0, &Traced, sizeof(Traced));
+	fprintf(stderr, "Trace: %u of %u entries, %u boots:", Traced.Count, Traced.Size, Traced.Boots);
+	for (uint8_t Index = 0; Index < Traced.Count; Index++)
+	{
+		const TraceEntry_t* Entry = &Traced.Entries[(Traced.Next - Traced.Count + Index) & (TRACE_ENTRIES - 1)];
+
+		fprintf(stderr, " %u:%s/%u=%u", Entry->Time, TraceNames[Entry->Event & TRACE_KIND_MASK],
+		        Entry->Event >> TRACE_PAD_SHIFT, Entry->Value);
+	}
+	fprintf(stderr, "\n");
+#endif
+
+#ifdef SERIAL_STREAM
+	if (Serial.Length)
+		fprintf(stderr, "Stream: %zu of %zu bytes sent, paused %u times\n", Serial.Sent, Serial.Length, Serial.Pauses);
+#endif
+
+	fprintf(stderr, "Simulated %u.%03u s: %u reports, %u changes, input held %u%% of the time\n",
+	        SimTime / 1000, SimTime % 1000, Stats.Reports, Stats.Changes, SimTime ? Stats.HeldMS * 100 / SimTime : 0);
+
+	fprintf(stderr, "Presses:");
+	for (uint8_t Bit = 0; Bit < 16; Bit++)
+	{
+		if (Stats.Presses[Bit])
+			fprintf(stderr, " %s=%u", ButtonNames[Bit], Stats.Presses[Bit]);
+	}
+	fprintf(stderr, "\n");
+
+	// The counters add up every pad. Each pad plays its own console at the pace of a single one, so the time a
+	// turn or a match takes is PADS times what the totals alone would make it.
+	if (Stats.TimedTurns)
+		fprintf(stderr, "Turns: %u, %u ms per turn\n", Stats.Turns, Stats.TurnMS * PADS / Stats.TimedTurns);
+
+	if (Stats.Matches > Stats.FirstMatches)
+	{
+		uint32_t MatchMS = (Stats.LastMatch - Stats.FirstMatch) * PADS / (Stats.Matches - Stats.FirstMatches);
+		uint32_t PerHour = MatchMS ? (uint32_t)(3600000UL / MatchMS) : 0;
+
+		fprintf(stderr, "Matches: %u, %u.%03u s of input per %u turn match (%u matches per hour on input time alone",
+		        Stats.Matches, MatchMS / 1000, MatchMS % 1000, TURNS, PerHour);
+		if (PADS > 1)
+			fprintf(stderr, " on each of %u pads, %u in all", PADS, PerHour * PADS);
+		fprintf(stderr, ")\n");
+	}
+}
+
+#ifdef AUTO_TUNE
+// Pulls the tune pin low for a moment once a scale is below what the game takes, like an operator watching the screen would.
+static void Operate(void)
+{
+	if (Operator.Pulling && SimTime - Operator.Pulled >= OPERATOR_PULL_MS + OPERATOR_BOUNCE_MS)
+	{
+		Operator.Pulling = false;
+		PINB |= (1 << TUNE_PIN);
+	}
+	else if (Operator.Pulling)
+	{
+		const uint32_t Held = SimTime - Operator.Pulled;
+		const bool     Bouncing = Held < OPERATOR_BOUNCE_MS || Held >= OPERATOR_PULL_MS;
+
+		if (Bouncing && (SimTime & 1))
+			PINB |= (1 << TUNE_PIN);
+		else
+			PINB &= ~(1 << TUNE_PIN);
+	}
+
+	bool Missing = MacroTiming.PressScale < Operator.Below || MacroTiming.ReleaseScale < Operator.Below;
+	if (Missing && !Operator.Pulling && (!Operator.Pulls || SimTime - Operator.Pulled >= OPERATOR_REST_MS))
+	{
+		Operator.Pulling = true;
+		Operator.Pulled  = SimTime;
+		Operator.Pulls++;
+		PINB &= ~(1 << TUNE_PIN);
+	}
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+	uint32_t Duration = 1200000;
+	uint32_t PollMS   = POLLING_MS;
+	uint32_t OutMS    = 0;
+	char*    Profile  = NULL;
+	char*    Stream   = NULL;
+	int      Option;
+
+	while ((Option = getopt(argc, argv, "s:p:o:e:i:t:q")) != -1)
+	{
+		switch (Option)
+		{
+			case 's': Duration = strtoul(optarg, NULL, 10) * 1000; break;
+			case 'p': PollMS   = strtoul(optarg, NULL, 10);        break;
+			case 'o': OutMS    = strtoul(optarg, NULL, 10);        break;
+			case 'e': Profile  = optarg;                           break;
+			case 'i': Stream   = optarg;                           break;
+#ifdef AUTO_TUNE
+			case 't': Operator.Below = strtoul(optarg, NULL, 10);  break;
+#endif
+			case 'q': Quiet    = true;                             break;
+			default:
+				fprintf(stderr, "Usage: %s [-s seconds] [-p poll_ms] [-o out_ms] [-e profile] [-i stream] [-t percent] [-q]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	if (!PollMS)
+		PollMS = 1;
+
+	for (uint8_t Pad = 0; Pad < PADS; Pad++)
+		OnWire[Pad] = (USB_JoystickReport_Input_t){ .HAT = HAT_CENTER, .LX = STICK_CENTER, .LY = STICK_CENTER, .RX = STICK_CENTER, .RY = STICK_CENTER };
+
+	// Nothing pulls the input pins low unless the simulation does.
+	PINB = 0xFF;
+	PIND = 0xFF;
+	SetupHardware();
+
+	// The host enumerates and configures us straight away.
+	USB_DeviceState = DEVICE_STATE_Configured;
+	EVENT_USB_Device_ConfigurationChanged();
+
+	if (Profile)
+		WriteProfile(Profile);
+
+	if (Stream)
+	{
+#ifndef SERIAL_STREAM
+		fprintf(stderr, "%s: this simulator was built without SERIAL_STREAM\n", Stream);
+		return 1;
+#endif
+		FILE* File = fopen(Stream, "rb");
+
+		if (!File)
+		{
+			perror(Stream);
+			return 1;
+		}
+		fseek(File, 0, SEEK_END);
+		Serial.Length = ftell(File);
+		rewind(File);
+		Serial.Data = malloc(Serial.Length ? Serial.Length : 1);
+		Serial.Length = fread(Serial.Data, 1, Serial.Length, File);
+		fclose(File);
+	}
+
+	for (SimTime = 0; SimTime < Duration; SimTime++)
+	{
+		// The host polls every pad in the same frame.
+		for (uint8_t Pad = 0; Pad < PADS; Pad++)
+		{
+			if (SimTime % PollMS == 0)
+				INReady[Pad] = true;
+			if (OutMS && SimTime % OutMS == 0)
+				OUTReceived[Pad] = true;
+		}
+
+#ifdef SERIAL_STREAM
+		FeedSerial();
+#endif
+#ifdef AUTO_TUNE
+		Operate();
+#endif
+
+		// The same order of work as the firmware's main loop, one pass per millisecond.
+		FillReportQueue();
+#if defined(INTERRUPT_DRIVEN) || defined(FRAME_CLOCK)
+		EVENT_USB_Device_StartOfFrame();
+#endif
+#ifndef INTERRUPT_DRIVEN
+		HID_Task();
+		USB_USBTask();
+#endif
+
+		if (OnWire[0].Button || OnWire[0].HAT != HAT_CENTER)
+			Stats.HeldMS++;
+	}
+
+	PrintSummary();
+	return 0;
+}
@@ -0,0 +1,350 @@
+#!/usr/bin/env python3
+"""Talk to running Splat-TT-Auto units from a PC, over their vendor control requests.
+
+The Switch never sends these requests, so this works while a unit is plugged into a
+PC (or a USB hub/splitter you can read from). Needs pyusb (pip install pyusb).
+
+    splatctl.py counters [--reset] [--watch SECONDS]
+    splatctl.py profile write Macros.bin | load | clear
+    splatctl.py probes [--reset]          (units built with make profile)
+    splatctl.py bench [--log FILE]        (units built with make bench)
+    splatctl.py trace [--reset]           (units built with make with-trace)
+"""
+
+import argparse
+import csv
+import os
+import struct
+import sys
+import time
+
+import usb.core
+
+VENDOR_ID = 0x0F0D
+PRODUCT_ID = 0x0092
+
+# bmRequestType values: vendor request to the device, in either direction.
+VENDOR_IN = 0xC0
+VENDOR_OUT = 0x40
+
+# VendorRequests_t in Descriptors.h
+REQ_GET_COUNTERS = 1
+REQ_RESET_COUNTERS = 2
+REQ_WRITE_PROFILE = 3
+REQ_LOAD_PROFILE = 4
+REQ_GET_PROBES = 5
+REQ_GET_BENCH = 6
+REQ_GET_TRACE = 7
+
+# Counters_t in Counters.h
+COUNTERS_FORMAT = "<BBHIIIIHBB"
+COUNTERS_VERSION = 3
+STATES = ["SYNC_CONTROLLER", "BREATHE", "PROCESS", "RECOVER", "DONE", "BENCH", "STREAM"]
+# WDRF in MCUSR
+RESET_WATCHDOG = 1 << 3
+
+# PROFILE_CHUNK_SIZE and ProfileStatus_t in Profile.h
+PROFILE_CHUNK_SIZE = 32
+PROFILE_STATUSES = ["no profile, built-in programs", "loaded", "bad version", "bad tick (other timing profile)",
+                    "bad length", "bad scale", "bad checksum"]
+
+
+def find_units():
+    units = list(usb.core.find(find_all=True, idVendor=VENDOR_ID, idProduct=PRODUCT_ID))
+    if not units:
+        sys.exit("No units found (VID %04x PID %04x)" % (VENDOR_ID, PRODUCT_ID))
+    return units
+
+
+def unit_name(dev):
+    return "bus %d addr %d" % (dev.bus, dev.address)
+
+
+def read_counters(dev):
+    data = bytes(dev.ctrl_transfer(VENDOR_IN, REQ_GET_COUNTERS, 0, 0, struct.calcsize(COUNTERS_FORMAT)))
+    version, state, syncs, uptime, reports, matches, turns, recoveries, reset_cause, rival = struct.unpack(COUNTERS_FORMAT, data)
+    if version != COUNTERS_VERSION:
+        raise RuntimeError("unsupported counters version %d" % version)
+    return {
+        "state": STATES[state] if state < len(STATES) else str(state),
+        "syncs": syncs,
+        "uptime": uptime,
+        "reports": reports,
+        "matches": matches,
+        "turns": turns,
+        "recoveries": recoveries,
+        "watchdog": bool(reset_cause & RESET_WATCHDOG),
+        "rival": rival,
+    }
+
+
+def print_counters(dev, counters):
+    hours = counters["uptime"] / 3600.0
+    per_hour = counters["matches"] / hours if hours else 0.0
+    print("%-16s %-15s up %7.2f h  %6d matches (%5.1f/h)  %7d turns  %9d reports  %d syncs  %d recoveries  rival %d%s"
+          % (unit_name(dev), counters["state"], hours, counters["matches"], per_hour,
+             counters["turns"], counters["reports"], counters["syncs"], counters["recoveries"], counters["rival"],
+             "  (watchdog reset)" if counters["watchdog"] else ""))
+
+
+def cmd_counters(args):
+    units = find_units()
+    if args.reset:
+        for dev in units:
+            dev.ctrl_transfer(VENDOR_OUT, REQ_RESET_COUNTERS, 0, 0, None)
+
+    # A unit whose turn count stops moving between two readings has most likely lost sync.
+    last = {}
+    while True:
+        for dev in units:
+            counters = read_counters(dev)
+            print_counters(dev, counters)
+            key = unit_name(dev)
+            if counters["state"] == "DONE":
+                print("%-16s has reached its match target" % key)
+            elif key in last and counters["turns"] == last[key] and counters["state"] == "PROCESS":
+                print("%-16s no turns passed since the last reading, check this unit" % key)
+            last[key] = counters["turns"]
+        if not args.watch:
+            break
+        time.sleep(args.watch)
+
+
+# Probes_t in Probe.h
+PROBES_FORMAT = "<BBBB" + "HHII" * 4 + "HH"
+PROBES_VERSION = 1
+PROBE_NAMES = ["HID_Task", "GetNextReport", "Macro_Run", "USB_USBTask"]
+
+
+def read_probes(dev):
+    try:
+        data = bytes(dev.ctrl_transfer(VENDOR_IN, REQ_GET_PROBES, 0, 0, struct.calcsize(PROBES_FORMAT)))
+    except usb.core.USBError:
+        return None
+    fields = struct.unpack(PROBES_FORMAT, data)
+    version, cycles_per_count, mhz = fields[0:3]
+    if version != PROBES_VERSION:
+        raise RuntimeError("unsupported probes version %d" % version)
+    probes = []
+    for index, name in enumerate(PROBE_NAMES):
+        low, high, total, runs = fields[4 + index * 4:8 + index * 4]
+        probes.append((name, low * cycles_per_count, high * cycles_per_count,
+                       total * cycles_per_count / runs if runs else 0.0, runs))
+    return {"mhz": mhz, "probes": probes, "missed": fields[-2], "late": fields[-1]}
+
+
+def cmd_probes(args):
+    for dev in find_units():
+        if args.reset:
+            dev.ctrl_transfer(VENDOR_OUT, REQ_RESET_COUNTERS, 0, 0, None)
+            continue
+        probes = read_probes(dev)
+        if probes is None:
+            print("%-16s not a profiling build (make profile)" % unit_name(dev))
+            continue
+        print("%-16s %d missed and %d late IN polls" % (unit_name(dev), probes["missed"], probes["late"]))
+        for name, low, high, average, runs in probes["probes"]:
+            if not runs:
+                print("  %-14s not run" % name)
+                continue
+            print("  %-14s min %6d  avg %8.1f  max %6d cycles (max %7.1f us)  %9d runs"
+                  % (name, low, average, high, high / float(probes["mhz"]), runs))
+
+
+# Bench_t in Bench.h
+BENCH_FORMAT = "<BBBB" + "BBBBBBHH" * 4
+BENCH_VERSION = 1
+BENCH_LOG_FIELDS = ["unit", "polling_ms", "in_interval_ms", "echoes", "presses", "registered",
+                    "wire_avg_ms", "wire_max_ms", "mirror_avg_ms", "mirror_max_ms"]
+
+
+def read_bench(dev):
+    try:
+        data = bytes(dev.ctrl_transfer(VENDOR_IN, REQ_GET_BENCH, 0, 0, struct.calcsize(BENCH_FORMAT)))
+    except usb.core.USBError:
+        return None
+    fields = struct.unpack(BENCH_FORMAT, data)
+    version, polling_ms, in_interval, done = fields[0:4]
+    if version != BENCH_VERSION:
+        raise RuntimeError("unsupported bench version %d" % version)
+    rows = []
+    for index in range(4):
+        echoes, presses, registered, wire_max, mirror_max, _, wire_total, mirror_total = fields[4 + index * 8:12 + index * 8]
+        rows.append({"echoes": echoes, "presses": presses, "registered": registered,
+                     "wire_avg_ms": wire_total / float(presses) if presses else 0.0, "wire_max_ms": wire_max,
+                     "mirror_avg_ms": mirror_total / float(registered) if registered else 0.0, "mirror_max_ms": mirror_max})
+    return {"polling_ms": polling_ms, "in_interval_ms": in_interval, "done": done, "rows": rows}
+
+
+def cmd_bench(args):
+    for dev in find_units():
+        bench = read_bench(dev)
+        if bench is None:
+            print("%-16s not a benchmark build (make bench)" % unit_name(dev))
+            continue
+        print("%-16s polling every %d ms (measured %s)%s"
+              % (unit_name(dev), bench["polling_ms"], "%d ms" % bench["in_interval_ms"] if bench["in_interval_ms"] else "n/a",
+                 "" if bench["done"] else ", still running"))
+        for row in bench["rows"]:
+            print("  %d echoes  %2d/%2d registered  wire avg %5.1f max %3d ms  mirror avg %5.1f max %3d ms"
+                  % (row["echoes"], row["registered"], row["presses"], row["wire_avg_ms"], row["wire_max_ms"],
+                     row["mirror_avg_ms"], row["mirror_max_ms"]))
+        if args.log and bench["done"]:
+            new = not os.path.exists(args.log)
+            with open(args.log, "a", newline="") as f:
+                writer = csv.DictWriter(f, fieldnames=BENCH_LOG_FIELDS)
+                if new:
+                    writer.writeheader()
+                for row in bench["rows"]:
+                    writer.writerow(dict(row, unit=unit_name(dev), polling_ms=bench["polling_ms"],
+                                         in_interval_ms=bench["in_interval_ms"]))
+
+    if args.log and os.path.exists(args.log):
+        # Across every build logged so far, the quickest round trip that never lost a press.
+        with open(args.log, newline="") as f:
+            reliable = [row for row in csv.DictReader(f) if int(row["presses"]) and row["registered"] == row["presses"]]
+        if reliable:
+            best = min(reliable, key=lambda row: float(row["mirror_avg_ms"]))
+            print("Fastest reliable setting in %s: %s ms polling with %s echoes (mirror avg %.1f ms)"
+                  % (args.log, best["polling_ms"], best["echoes"], float(best["mirror_avg_ms"])))
+        else:
+            print("No setting in %s registered every press" % args.log)
+
+
+# Trace_t and TraceEvent_t in Trace.h
+TRACE_HEADER_FORMAT = "<HBBBBH"
+TRACE_ENTRY_FORMAT = "<HBB"
+TRACE_MAGIC = 0x5254
+TRACE_VERSION = 1
+TRACE_MAX_ENTRIES = 128
+TRACE_PAD_SHIFT = 6
+TRACE_EVENTS = ["BOOT", "CONNECT", "DISCONNECT", "SUSPEND", "WAKEUP", "CONFIGURED", "STATE", "PROGRAM", "CUT", "LATE_IN"]
+# PROFILE_PROGRAM_NAMES in Profile.h
+PROGRAM_NAMES = ["deck_select", "pass_turn", "results", "popups", "rematch", "recover", "pass_again",
+                 "rival_leave", "rival_up", "rival_down", "rival_pick"]
+
+
+def read_trace(dev):
+    header_size = struct.calcsize(TRACE_HEADER_FORMAT)
+    entry_size = struct.calcsize(TRACE_ENTRY_FORMAT)
+    try:
+        data = bytes(dev.ctrl_transfer(VENDOR_IN, REQ_GET_TRACE, 0, 0, header_size + TRACE_MAX_ENTRIES * entry_size))
+    except usb.core.USBError:
+        return None
+    magic, version, size, next_entry, count, boots = struct.unpack(TRACE_HEADER_FORMAT, data[:header_size])
+    if magic != TRACE_MAGIC or version != TRACE_VERSION:
+        raise RuntimeError("unsupported trace version %d" % version)
+    # Oldest first: once the ring is full, the next entry to be overwritten is the oldest one.
+    entries = []
+    for index in range(count):
+        slot = (next_entry - count + index) % size
+        entries.append(struct.unpack_from(TRACE_ENTRY_FORMAT, data, header_size + slot * entry_size))
+    return {"boots": boots, "size": size, "entries": entries}
+
+
+def describe_event(kind, value):
+    if kind == "BOOT":
+        return "reset cause 0x%02x%s" % (value, " (watchdog)" if value & RESET_WATCHDOG else "")
+    if kind == "CONFIGURED":
+        return "ok" if value else "endpoint setup failed"
+    if kind == "STATE":
+        return STATES[value] if value < len(STATES) else str(value)
+    if kind == "PROGRAM":
+        slot, turns = value & 0x0F, value >> 4
+        return "%s after %d turns" % (PROGRAM_NAMES[slot] if slot < len(PROGRAM_NAMES) else str(slot), turns)
+    if kind == "CUT":
+        return "at step offset %s" % ("255 or later" if value == 255 else value)
+    if kind == "LATE_IN":
+        return "%s ms after the previous report" % ("255 or more" if value == 255 else value)
+    return ""
+
+
+def cmd_trace(args):
+    for dev in find_units():
+        if args.reset:
+            dev.ctrl_transfer(VENDOR_OUT, REQ_RESET_COUNTERS, 0, 0, None)
+            continue
+        trace = read_trace(dev)
+        if trace is None:
+            print("%-16s not a trace build (make with-trace)" % unit_name(dev))
+            continue
+        print("%-16s %d of %d events, kept over %d boots" % (unit_name(dev), len(trace["entries"]), trace["size"], trace["boots"]))
+        # The clock only counts milliseconds since the boot before each event, wrapping every 65 s.
+        for time_ms, event, value in trace["entries"]:
+            kind = event & ((1 << TRACE_PAD_SHIFT) - 1)
+            kind = TRACE_EVENTS[kind] if kind < len(TRACE_EVENTS) else str(kind)
+            print("  %5d.%03d  pad %d  %-10s %s" % (time_ms // 1000, time_ms % 1000, event >> TRACE_PAD_SHIFT, kind,
+                                                   describe_event(kind, value)))
+
+
+def write_profile(dev, data):
+    """Returns the offset of the chunk the unit refused, which stalls a write past the end of its EEPROM, or None."""
+    for offset in range(0, len(data), PROFILE_CHUNK_SIZE):
+        try:
+            dev.ctrl_transfer(VENDOR_OUT, REQ_WRITE_PROFILE, offset, 0, data[offset:offset + PROFILE_CHUNK_SIZE])
+        except usb.core.USBError:
+            return offset
+    return None
+
+
+def load_profile(dev):
+    status = dev.ctrl_transfer(VENDOR_IN, REQ_LOAD_PROFILE, 0, 0, 1)[0]
+    return PROFILE_STATUSES[status] if status < len(PROFILE_STATUSES) else str(status)
+
+
+def cmd_profile(args):
+    if args.action == "write":
+        if not args.file:
+            sys.exit("profile write needs the profile made by make macro-profile")
+        with open(args.file, "rb") as f:
+            data = f.read()
+    elif args.action == "clear":
+        # Without the magic at the start, the unit goes back to its built-in programs.
+        data = b"\xff\xff"
+    else:
+        data = b""
+
+    failed = False
+    for dev in find_units():
+        refused = write_profile(dev, data)
+        if refused is not None:
+            print("%-16s write refused at byte %d, the profile doesn't fit" % (unit_name(dev), refused))
+            failed = True
+            continue
+        print("%-16s %s" % (unit_name(dev), load_profile(dev)))
+    if failed:
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    counters = commands.add_parser("counters", help="read the throughput counters of every unit")
+    counters.add_argument("--reset", action="store_true", help="zero the counters first")
+    counters.add_argument("--watch", type=float, metavar="SECONDS", help="keep reading at this interval")
+    counters.set_defaults(func=cmd_counters)
+
+    profile = commands.add_parser("profile", help="write, reload or clear the macro profile in EEPROM of every unit")
+    profile.add_argument("action", choices=["write", "load", "clear"])
+    profile.add_argument("file", nargs="?", help="profile to write, made by make macro-profile")
+    profile.set_defaults(func=cmd_profile)
+
+    probes = commands.add_parser("probes", help="read the cycle counts of every unit built with make profile")
+    probes.add_argument("--reset", action="store_true", help="clear the counts (and the throughput counters) instead")
+    probes.set_defaults(func=cmd_probes)
+
+    bench = commands.add_parser("bench", help="read the latency table of every unit built with make bench")
+    bench.add_argument("--log", metavar="FILE", help="append finished tables to this CSV and pick the fastest reliable setting")
+    bench.set_defaults(func=cmd_bench)
+
+    trace = commands.add_parser("trace", help="print the event trace of every unit built with make with-trace")
+    trace.add_argument("--reset", action="store_true", help="clear the trace (and the throughput counters) instead")
+    trace.set_defaults(func=cmd_trace)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
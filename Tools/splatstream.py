@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+"""Stream macro bytecode to a Splat-TT-Auto unit built with make with-serial-stream.
+
+The bytecode comes from make macro-stream (Tools/macroc -s). The unit holds us back with
+XON/XOFF, which the serial driver honours, so the whole file can be written at once.
+Needs pyserial (pip install pyserial).
+
+    splatstream.py PORT Stream.bin [--repeat N] [--baud BAUD]
+"""
+
+import argparse
+import sys
+
+import serial
+
+# STREAM_BAUD in Stream.h
+STREAM_BAUD = 115200
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("port", help="serial port wired to the unit's USART, e.g. /dev/ttyUSB0")
+    parser.add_argument("file", help="bytecode written by make macro-stream")
+    parser.add_argument("--repeat", type=int, default=1, help="send the file this many times, 0 for ever")
+    parser.add_argument("--baud", type=int, default=STREAM_BAUD)
+    args = parser.parse_args()
+
+    with open(args.file, "rb") as stream_file:
+        code = stream_file.read()
+    if not code:
+        sys.exit("%s is empty" % args.file)
+
+    try:
+        port = serial.Serial(args.port, args.baud, xonxoff=True)
+    except serial.SerialException as error:
+        sys.exit(str(error))
+
+    # Every repeat follows on straight away, so the unit plays them back to back.
+    sent = 0
+    with port:
+        while args.repeat == 0 or sent < args.repeat:
+            port.write(code)
+            port.flush()
+            sent += 1
+            print("sent %s %d time(s), %d bytes each" % (args.file, sent, len(code)))
+
+
+if __name__ == "__main__":
+    main()
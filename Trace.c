@@ -0,0 +1,124 @@
+/** \file
+ *
+ *  Event trace, built in with EVENT_TRACE (make with-trace). A small ring in RAM records
+ *  the state changes of every pad, the programs it starts and where they were cut short,
+ *  the USB events and IN reports that went out late, so what led up to a desync can be
+ *  read out afterwards with Tools/splatctl.py trace.
+ *
+ *  The ring lives outside .bss, so it survives the watchdog reset that follows most
+ *  desyncs, and it is then saved to the end of EEPROM so unplugging the unit to read it
+ *  doesn't lose it. Events are only written to RAM, which takes a few dozen cycles.
+ */
+
+#include <avr/io.h>
+#include <util/atomic.h>
+#include <string.h>
+
+#include "Descriptors.h"
+#include "Trace.h"
+
+#ifdef EVENT_TRACE
+
+Trace_t Trace __attribute__((section(".noinit")));
+
+// Set while the ring is being read out.
+static volatile bool Trace_Holding;
+// When each pad last sent an IN report.
+static Clock_ms_t    Trace_LastIN[PADS];
+
+// Returns true if the trace is one we left behind, rather than what RAM or EEPROM came up with.
+static bool Trace_Valid(void)
+{
+	return Trace.Magic == TRACE_MAGIC && Trace.Version == TRACE_VERSION && Trace.Size == TRACE_ENTRIES &&
+	       Trace.Next < TRACE_ENTRIES && Trace.Count <= TRACE_ENTRIES;
+}
+
+// Empties the trace in RAM.
+static void Trace_Clear(void)
+{
+	memset(&Trace, 0, sizeof(Trace));
+	Trace.Magic   = TRACE_MAGIC;
+	Trace.Version = TRACE_VERSION;
+	Trace.Size    = TRACE_ENTRIES;
+}
+
+void Trace_Init(const uint8_t ResetCause, const bool Unflagged)
+{
+	// Without its flags, a reset may have been the watchdog's as well as the button's.
+	const bool Watchdog = (ResetCause & (1 << WDRF)) || Unflagged;
+
+	// Only a watchdog or external reset leaves the RAM as it was. After anything else, we carry on with the
+	// trace last saved to EEPROM, if any.
+	if (!(Watchdog || (ResetCause & (1 << EXTRF))) || !Trace_Valid())
+	{
+		eeprom_read_block(&Trace, TRACE_EEPROM_ADDRESS, sizeof(Trace));
+		if (!Trace_Valid())
+			Trace_Clear();
+	}
+
+	Trace.Boots++;
+	Trace_Record(TRACE_BOOT, 0, ResetCause);
+
+	// The watchdog only resets us when something went wrong, so this trace is worth keeping over a power cycle.
+	// It's at most a few hundred bytes once per reset, and bytes that are already right aren't written again.
+	if (Watchdog)
+		eeprom_update_block(&Trace, (void*)TRACE_EEPROM_ADDRESS, sizeof(Trace));
+}
+
+void Trace_Reset(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		Trace_Clear();
+	}
+
+	// Without its magic, the saved trace isn't picked up again.
+	eeprom_update_byte((uint8_t*)TRACE_EEPROM_ADDRESS, 0xFF);
+}
+
+void Trace_Record(const uint8_t Event, const uint8_t Pad, const uint8_t Value)
+{
+	const Clock_ms_t Now = Clock_Millis();
+
+	// Events are also recorded from the USB interrupt in some builds, so an entry is claimed and filled in one go.
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (!Trace_Holding)
+		{
+			TraceEntry_t* const Entry = &Trace.Entries[Trace.Next];
+
+			Entry->Time  = Now;
+			Entry->Event = (Pad << TRACE_PAD_SHIFT) | Event;
+			Entry->Value = Value;
+
+			Trace.Next = (Trace.Next + 1) & (TRACE_ENTRIES - 1);
+			if (Trace.Count < TRACE_ENTRIES)
+				Trace.Count++;
+		}
+	}
+}
+
+void Trace_Hold(const bool Hold)
+{
+	Trace_Holding = Hold;
+}
+
+void Trace_Configured(const bool Success, const Clock_ms_t Now)
+{
+	// Nothing was polled while the host set us up, so the first reports after it aren't late.
+	for (uint8_t Pad = 0; Pad < PADS; Pad++)
+		Trace_LastIN[Pad] = Now;
+
+	Trace_Record(TRACE_CONFIGURED, 0, Success);
+}
+
+void Trace_RecordIN(const uint8_t Pad, const Clock_ms_t Now)
+{
+	const Clock_ms_t Gap = Now - Trace_LastIN[Pad];
+
+	Trace_LastIN[Pad] = Now;
+	if (Gap > TRACE_LATE_MS)
+		Trace_Record(TRACE_LATE_IN, Pad, (Gap > UINT8_MAX) ? UINT8_MAX : Gap);
+}
+
+#endif
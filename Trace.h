@@ -0,0 +1,114 @@
+/** \file
+ *
+ *  Header file for Trace.c.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/* Includes: */
+#include <avr/eeprom.h>
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Clock.h"
+#include "Timing.h"
+
+// Macros
+// First two bytes of a trace ("TR", little endian), and the layout version of Trace_t, bumped whenever a field is added or moved.
+#define TRACE_MAGIC   0x5254
+#define TRACE_VERSION 1
+
+// Events the ring holds before the oldest are overwritten, 4 bytes of RAM each. Set with make with-trace TRACE_ENTRIES=32.
+#ifndef TRACE_ENTRIES
+	#define TRACE_ENTRIES 16
+#endif
+#if TRACE_ENTRIES < 2 || TRACE_ENTRIES > 128 || (TRACE_ENTRIES & (TRACE_ENTRIES - 1))
+	#error TRACE_ENTRIES has to be a power of two from 2 to 128.
+#endif
+
+// Size of Trace_t in bytes, which the trace takes of RAM and of EEPROM each. It may have a quarter of the RAM,
+// which leaves the rest to the report queues and the stack, and half the EEPROM, which leaves the rest to the profile.
+#define TRACE_SIZE (8 + 4 * TRACE_ENTRIES)
+#ifdef EVENT_TRACE
+	#if TRACE_SIZE > (RAMEND - RAMSTART + 1) / 4
+		#error The trace takes more than a quarter of the RAM of this MCU, lower TRACE_ENTRIES.
+	#endif
+	#if TRACE_SIZE > (E2END + 1) / 2
+		#error The trace takes more than half of the EEPROM of this MCU, lower TRACE_ENTRIES.
+	#endif
+#endif
+
+// The pad an event is about goes in the top two bits of its Event byte.
+#define TRACE_PAD_SHIFT 6
+#define TRACE_KIND_MASK ((1 << TRACE_PAD_SHIFT) - 1)
+
+// An IN report taken this long after the pad's previous one is traced: the host stopped polling, or we had nothing for it.
+#define TRACE_LATE_MS   (POLLING_MS * 4)
+
+// The trace kept over a power cycle sits at the end of EEPROM, after the profile (see Profile.h).
+#define TRACE_EEPROM_ADDRESS ((const uint8_t*)(E2END + 1 - sizeof(Trace_t)))
+
+// Record an event in the ring. This compiles to nothing unless EVENT_TRACE is defined.
+#ifdef EVENT_TRACE
+	#define TRACE(event, pad, value) Trace_Record(event, pad, value)
+#else
+	#define TRACE(event, pad, value)
+#endif
+
+// Type Defines
+// Kinds of events traced, and what the Value of each holds.
+typedef enum {
+	TRACE_BOOT,       // Setup after a reset, MCUSR at power up
+	TRACE_CONNECT,    // The device is enumerating
+	TRACE_DISCONNECT, // The host is gone
+	TRACE_SUSPEND,    // The host suspended the bus
+	TRACE_WAKEUP,     // The host resumed it
+	TRACE_CONFIGURED, // The host (re)configured us, 1 if every endpoint was set up
+	TRACE_STATE,      // A pad's report state machine moved on, to the State_t in Value
+	TRACE_PROGRAM,    // A pad started a program: its profile slot in the low nibble, the turns passed in the high one
+	TRACE_CUT,        // A pad's program was cut short, at the offset of the step running (255 for any further in)
+	TRACE_LATE_IN,    // A pad's IN report went out late, this many ms after the one before (255 for any longer)
+} TraceEvent_t;
+
+// One event, stamped with the millisecond clock since the TRACE_BOOT before it.
+typedef struct {
+	Clock_ms_t Time;
+	uint8_t    Event; // TraceEvent_t, with the pad in the top bits
+	uint8_t    Value;
+} TraceEntry_t;
+
+// Ring of the latest events, read out by a PC with the VENDOR_REQ_GetTrace control request. It survives
+// watchdog and external resets in RAM, and is saved to EEPROM after a watchdog reset so a power cycle
+// doesn't lose it either. The layout is little endian and packed as declared, see Tools/splatctl.py.
+typedef struct {
+	uint16_t     Magic;   // TRACE_MAGIC
+	uint8_t      Version; // TRACE_VERSION
+	uint8_t      Size;    // TRACE_ENTRIES
+	uint8_t      Next;    // Entry the next event goes in, which holds the oldest one once the ring is full
+	uint8_t      Count;   // Entries filled, up to TRACE_ENTRIES
+	uint16_t     Boots;   // Resets the trace has been kept over since it was last cleared, counting power up
+	TraceEntry_t Entries[TRACE_ENTRIES];
+} Trace_t;
+
+_Static_assert(sizeof(Trace_t) == TRACE_SIZE, "TRACE_SIZE has to match Trace_t");
+
+// Variables
+extern Trace_t Trace;
+
+// Function Prototypes
+// Carry on with the trace kept over the reset, if there is one, and record the boot. Unflagged is set after
+// a reset whose MCUSR flags the bootloader cleared (see SetupHardware()).
+void Trace_Init(const uint8_t ResetCause, const bool Unflagged);
+// Start over with an empty trace, in RAM and in EEPROM.
+void Trace_Reset(void);
+// Add an event to the ring, of a TraceEvent_t kind.
+void Trace_Record(const uint8_t Event, const uint8_t Pad, const uint8_t Value);
+// Stop recording while the ring is read out, so the host gets it as it was when asked.
+void Trace_Hold(const bool Hold);
+// Note the host's (re)configuration, and every IN report a pad sends after it.
+void Trace_Configured(const bool Success, const Clock_ms_t Now);
+void Trace_RecordIN(const uint8_t Pad, const Clock_ms_t Now);
+
+#endif
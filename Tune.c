@@ -0,0 +1,104 @@
+/** \file
+ *
+ *  Timing auto-tuner, built in with AUTO_TUNE (make tune). Every match played shortens
+ *  the presses a little, through the press scale of the EEPROM profile, until the operator
+ *  pulls TUNE_PIN low because the game started to miss them. The scale is then backed off
+ *  by a safety margin, and the gaps between presses (the release scale) are tuned the same
+ *  way. Both results are saved to the profile, so every build runs at them from then on.
+ */
+
+#include <avr/io.h>
+
+#include "Macro.h"
+#include "Profile.h"
+#include "Tune.h"
+
+#ifdef AUTO_TUNE
+
+// Scale being tuned, then TUNE_DONE once both are saved.
+enum {
+	TUNE_PRESS,
+	TUNE_RELEASE,
+	TUNE_DONE,
+};
+
+static uint8_t    Tune_Scale;
+static bool       Tune_Low;     // The pin was low when last read
+static bool       Tune_Counted; // and that pull has been counted, or started too soon after the last one
+static bool       Tune_Resting; // A pull was counted less than TUNE_HOLDOFF_MS ago
+static Clock_ms_t Tune_LowSince;
+static Clock_ms_t Tune_CountedAt;
+
+// Returns where the scale being tuned is kept.
+static uint8_t* Tune_Current(void)
+{
+	return (Tune_Scale == TUNE_PRESS) ? &MacroTiming.PressScale : &MacroTiming.ReleaseScale;
+}
+
+// Moves on to the next scale, saving both once the last one is tuned.
+static void Tune_Next(void)
+{
+	if (++Tune_Scale == TUNE_DONE)
+		Profile_SaveScales(MacroTiming.PressScale, MacroTiming.ReleaseScale);
+}
+
+void Tune_Init(void)
+{
+	DDRB  &= ~(1 << TUNE_PIN);
+	PORTB |= (1 << TUNE_PIN);
+
+	Tune_Scale   = TUNE_PRESS;
+	Tune_Low     = false;
+	Tune_Resting = false;
+}
+
+bool Tune_Dropped(const Clock_ms_t Now)
+{
+	if (Tune_Resting && (Clock_ms_t)(Now - Tune_CountedAt) >= TUNE_HOLDOFF_MS)
+		Tune_Resting = false;
+
+	if (PINB & (1 << TUNE_PIN))
+	{
+		Tune_Low = false;
+		return false;
+	}
+
+	// A switch bounces for a few ms when pulled and let go of, so each pull is only taken once it has held, and
+	// what the switch does right after one is taken is left alone. Only a new pull counts for the next scale.
+	if (!Tune_Low)
+	{
+		Tune_Low      = true;
+		Tune_Counted  = Tune_Resting;
+		Tune_LowSince = Now;
+	}
+	if (Tune_Counted || (Clock_ms_t)(Now - Tune_LowSince) < TUNE_DEBOUNCE_MS || Tune_Scale == TUNE_DONE)
+		return false;
+
+	Tune_Counted   = true;
+	Tune_Resting   = true;
+	Tune_CountedAt = Now;
+
+	uint8_t* const Scale = Tune_Current();
+	*Scale = (*Scale > UINT8_MAX - TUNE_MARGIN) ? UINT8_MAX : *Scale + TUNE_MARGIN;
+	Tune_Next();
+	return true;
+}
+
+void Tune_MatchPlayed(void)
+{
+	if (Tune_Scale == TUNE_DONE)
+		return;
+
+	// Once at the bottom without a press being dropped, the scale is as short as we go.
+	uint8_t* const Scale = Tune_Current();
+	if (*Scale < TUNE_MIN_SCALE + TUNE_STEP)
+	{
+		*Scale = TUNE_MIN_SCALE;
+		Tune_Next();
+		return;
+	}
+
+	*Scale -= TUNE_STEP;
+}
+
+#endif
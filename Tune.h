@@ -0,0 +1,41 @@
+/** \file
+ *
+ *  Header file for Tune.c.
+ */
+
+#ifndef _TUNE_H_
+#define _TUNE_H_
+
+/* Includes: */
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "Clock.h"
+
+// Macros
+// PORTB pin the operator pulls to ground once the game stops taking the presses. On the UNO R3 that's
+// MISO on the 16u2's ICSP header, with GND on the same header.
+#ifndef TUNE_PIN
+	#define TUNE_PIN 3
+#endif
+// Percentage points taken off the scale being tuned after every match played without the operator
+// stepping in, and put back on top of where the presses dropped.
+#define TUNE_STEP      5
+#define TUNE_MARGIN    15
+// Lowest scale tried, in %. A press scaled this far down is shorter than any report window already.
+#define TUNE_MIN_SCALE 20
+// A pull only counts once the pin has stayed low this long, in ms, so a bouncing switch is one pull,
+// and no other pull counts for a while after it.
+#define TUNE_DEBOUNCE_MS 20
+#define TUNE_HOLDOFF_MS  2000
+
+// Function Prototypes
+// Set up the operator's pin and start tuning from the scales in use.
+void Tune_Init(void);
+// Returns true once when the operator has signalled that presses were dropped. The scale being tuned is
+// backed off by TUNE_MARGIN, and once both are tuned they are saved to the EEPROM profile.
+bool Tune_Dropped(const Clock_ms_t Now);
+// Shortens the scale being tuned, after a match was played without presses being dropped.
+void Tune_MatchPlayed(void);
+
+#endif